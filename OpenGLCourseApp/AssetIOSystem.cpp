@@ -0,0 +1,122 @@
+#include "AssetIOSystem.h"
+
+AssetIOStream::AssetIOStream()
+{
+  position = 0;
+}
+
+bool AssetIOStream::Open(const char* fileLocation)
+{
+  position = 0;
+  return FileSystem::ReadFile(fileLocation, file);
+}
+
+size_t AssetIOStream::Read(void* buffer, size_t size, size_t count)
+{
+  if (size == 0)
+  {
+    return 0;
+  }
+
+  // like fread, only hand back whole elements
+  size_t available = (file.GetSize() - position) / size;
+  if (count > available)
+  {
+    count = available;
+  }
+
+  memcpy(buffer, file.GetData() + position, size * count);
+  position += size * count;
+
+  return count;
+}
+
+size_t AssetIOStream::Write(const void*, size_t, size_t)
+{
+  // assets are read only
+  return 0;
+}
+
+aiReturn AssetIOStream::Seek(size_t offset, aiOrigin origin)
+{
+  size_t newPosition = 0;
+
+  switch (origin)
+  {
+    case aiOrigin_SET:
+      newPosition = offset;
+      break;
+    case aiOrigin_CUR:
+      newPosition = position + offset;
+      break;
+    case aiOrigin_END:
+      // assimp passes the offset as a positive distance back from the end
+      if (offset > file.GetSize())
+      {
+        return aiReturn_FAILURE;
+      }
+      newPosition = file.GetSize() - offset;
+      break;
+    default:
+      return aiReturn_FAILURE;
+  }
+
+  if (newPosition > file.GetSize())
+  {
+    return aiReturn_FAILURE;
+  }
+
+  position = newPosition;
+  return aiReturn_SUCCESS;
+}
+
+size_t AssetIOStream::Tell() const
+{
+  return position;
+}
+
+size_t AssetIOStream::FileSize() const
+{
+  return file.GetSize();
+}
+
+void AssetIOStream::Flush(){}
+
+AssetIOStream::~AssetIOStream(){}
+
+AssetIOSystem::AssetIOSystem(){}
+
+bool AssetIOSystem::Exists(const char* fileLocation) const
+{
+  return FileSystem::Exists(fileLocation);
+}
+
+char AssetIOSystem::getOsSeparator() const
+{
+  return '/';
+}
+
+Assimp::IOStream* AssetIOSystem::Open(const char* fileLocation, const char* mode)
+{
+  // we can only ever read
+  if (strchr(mode, 'w') || strchr(mode, 'a'))
+  {
+    return nullptr;
+  }
+
+  AssetIOStream* stream = new AssetIOStream();
+  if (!stream->Open(fileLocation))
+  {
+    delete stream;
+    return nullptr;
+  }
+
+  return stream;
+}
+
+void AssetIOSystem::Close(Assimp::IOStream* stream)
+{
+  delete stream;
+}
+
+AssetIOSystem::~AssetIOSystem(){}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+#include "FileSystem.h"
+
+// Lets Assimp read models (and the .mtl files they pull in) through the
+// FileSystem, so they come out of the asset pack like everything else.
+class AssetIOStream : public Assimp::IOStream
+{
+  public:
+    AssetIOStream();
+
+    bool Open(const char* fileLocation);
+
+    size_t Read(void* buffer, size_t size, size_t count);
+    size_t Write(const void* buffer, size_t size, size_t count);
+    aiReturn Seek(size_t offset, aiOrigin origin);
+    size_t Tell() const;
+    size_t FileSize() const;
+    void Flush();
+
+    ~AssetIOStream();
+
+  private:
+    AssetFile file;
+    size_t position;
+};
+
+class AssetIOSystem : public Assimp::IOSystem
+{
+  public:
+    AssetIOSystem();
+
+    bool Exists(const char* fileLocation) const;
+    char getOsSeparator() const;
+    Assimp::IOStream* Open(const char* fileLocation, const char* mode = "rb");
+    void Close(Assimp::IOStream* stream);
+
+    ~AssetIOSystem();
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// On-disk layout of an asset pack (assets.pak), written by AssetPacker.cpp
+// and read by FileSystem.
+//
+//   AssetPackHeader
+//   payloads, each starting on an ASSET_PACK_ALIGNMENT boundary
+//   AssetPackEntry[entryCount], sorted by hash
+//   file names, not null terminated
+//
+// Everything is little-endian and mapped straight into memory, so the
+// structs only use fixed size types and are padded to 8 bytes by hand.
+
+const char ASSET_PACK_MAGIC[8] = { 'O', 'G', 'L', 'P', 'A', 'C', 'K', '\0' };
+const uint32_t ASSET_PACK_VERSION = 1;
+const uint32_t ASSET_PACK_ALIGNMENT = 64;
+
+// entry flags
+const uint32_t ASSET_ENTRY_LZ4 = 1;
+
+struct AssetPackHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t entryCount;
+  uint64_t tocOffset;
+  uint64_t namesOffset;
+};
+
+struct AssetPackEntry
+{
+  uint32_t hash;
+  uint32_t flags;
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  uint64_t offset;
+  uint64_t storedSize; // size in the pack, different when compressed
+  uint64_t size;       // size once it's been read back out
+};
+
+// FNV-1a, used for looking names up in the table of contents. Paths are
+// compared with '\' and '/' treated the same.
+inline uint32_t HashAssetPath(const char* path, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = path[i] == '\\' ? '/' : path[i];
+    hash = (hash ^ (unsigned char)c) * 16777619u;
+  }
+
+  return hash;
+}
@@ -0,0 +1,217 @@
+// Packs every file in the given directories into one asset pack.
+//   ./pack.out assets.pak Shaders Textures Models
+// Files are written a directory at a time in the order the directories are
+// given, sorted by name within each one, so the same files always make the
+// same pack. Build with `make pack`.
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "AssetPack.h"
+
+struct PackFile
+{
+  std::string name;
+  std::string path;
+};
+
+void CollectFiles(const std::string& dirName, std::vector<PackFile>& files)
+{
+  DIR* dir = opendir(dirName.c_str());
+  if (!dir)
+  {
+    printf("Failed to open %s\n", dirName.c_str());
+    return;
+  }
+
+  std::vector<std::string> names;
+  while (dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+
+    // skip hidden files and editor backups
+    if (name[0] == '.' || name[name.size() - 1] == '~')
+    {
+      continue;
+    }
+
+    names.push_back(name);
+  }
+
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    std::string path = dirName + "/" + names[i];
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+      continue;
+    }
+
+    if (S_ISDIR(info.st_mode))
+    {
+      CollectFiles(path, files);
+    }
+    else if (S_ISREG(info.st_mode))
+    {
+      PackFile file;
+      file.name = path;
+      file.path = path;
+      files.push_back(file);
+    }
+  }
+}
+
+bool ReadWholeFile(const std::string& path, std::vector<char>& contents)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+  {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  contents.resize(length);
+  size_t read = length > 0 ? fread(&contents[0], 1, length, file) : 0;
+  fclose(file);
+
+  return read == (size_t)length;
+}
+
+void WritePadding(FILE* out, uint64_t& offset)
+{
+  static const char zeros[ASSET_PACK_ALIGNMENT] = { 0 };
+
+  uint64_t padding = (ASSET_PACK_ALIGNMENT - offset % ASSET_PACK_ALIGNMENT) % ASSET_PACK_ALIGNMENT;
+  fwrite(zeros, 1, padding, out);
+  offset += padding;
+}
+
+bool SortByHash(const AssetPackEntry& a, const AssetPackEntry& b)
+{
+  return a.hash < b.hash;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    printf("usage: %s <pack> <directory>...\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<PackFile> files;
+  for (int i = 2; i < argc; i++)
+  {
+    CollectFiles(argv[i], files);
+  }
+
+  FILE* out = fopen(argv[1], "wb");
+  if (!out)
+  {
+    printf("Failed to create %s\n", argv[1]);
+    return 1;
+  }
+
+  // the header gets written again at the end once we know the offsets
+  AssetPackHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+  header.version = ASSET_PACK_VERSION;
+  fwrite(&header, sizeof(header), 1, out);
+
+  uint64_t offset = sizeof(header);
+  uint64_t rawTotal = 0, storedTotal = 0;
+
+  std::vector<AssetPackEntry> entries;
+  std::string names;
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    std::vector<char> contents;
+    if (!ReadWholeFile(files[i].path, contents))
+    {
+      printf("Failed to read %s\n", files[i].path.c_str());
+      continue;
+    }
+
+    WritePadding(out, offset);
+
+    AssetPackEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.hash = HashAssetPath(files[i].name.c_str(), files[i].name.size());
+    entry.nameOffset = names.size();
+    entry.nameLength = files[i].name.size();
+    entry.offset = offset;
+    entry.size = contents.size();
+    entry.storedSize = contents.size();
+    names += files[i].name;
+
+#ifdef USE_LZ4
+    // only keep the compressed version when it's a real saving. Most of the
+    // jpgs and pngs are already compressed and would just cost decode time.
+    if (!contents.empty())
+    {
+      std::vector<char> compressed(LZ4_compressBound(contents.size()));
+      int compressedSize = LZ4_compress_default(&contents[0], &compressed[0],
+          contents.size(), compressed.size());
+
+      if (compressedSize > 0 && (size_t)compressedSize < contents.size() * 9 / 10)
+      {
+        contents.assign(compressed.begin(), compressed.begin() + compressedSize);
+        entry.storedSize = compressedSize;
+        entry.flags |= ASSET_ENTRY_LZ4;
+      }
+    }
+#endif
+
+    if (!contents.empty())
+    {
+      fwrite(&contents[0], 1, contents.size(), out);
+    }
+
+    offset += entry.storedSize;
+    rawTotal += entry.size;
+    storedTotal += entry.storedSize;
+    entries.push_back(entry);
+  }
+
+  // table of contents, sorted so the reader can binary search it
+  std::stable_sort(entries.begin(), entries.end(), SortByHash);
+
+  WritePadding(out, offset);
+  header.tocOffset = offset;
+  header.entryCount = entries.size();
+  if (!entries.empty())
+  {
+    fwrite(&entries[0], sizeof(AssetPackEntry), entries.size(), out);
+  }
+  offset += sizeof(AssetPackEntry) * entries.size();
+
+  header.namesOffset = offset;
+  fwrite(names.data(), 1, names.size(), out);
+
+  fseek(out, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, out);
+  fclose(out);
+
+  printf("Packed %zu files into %s (%.1f MB -> %.1f MB)\n",
+      entries.size(), argv[1],
+      rawTotal / (1024.0 * 1024.0), storedTotal / (1024.0 * 1024.0));
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "CommandList.h"
+
+#include "DrawData.h"
+
+CommandList::CommandList()
+{
+  drawCount = 0;
+}
+
+void CommandList::Clear()
+{
+  commands.clear();
+  drawCount = 0;
+}
+
+void CommandList::SetDraw(int drawID)
+{
+  Command command;
+  command.type = COMMAND_SET_DRAW;
+  command.drawID = drawID;
+  commands.push_back(command);
+}
+
+void CommandList::SetMaterial(Material* material)
+{
+  Command command;
+  command.type = COMMAND_SET_MATERIAL;
+  command.material = material;
+  commands.push_back(command);
+}
+
+void CommandList::BindTexture(Texture* texture)
+{
+  Command command;
+  command.type = COMMAND_BIND_TEXTURE;
+  command.texture = texture;
+  commands.push_back(command);
+}
+
+void CommandList::DrawMesh(Mesh* mesh)
+{
+  Command command;
+  command.type = COMMAND_DRAW_MESH;
+  command.mesh = mesh;
+  commands.push_back(command);
+  drawCount++;
+}
+
+void CommandList::DrawModel(Model* model, bool bindTextures)
+{
+  Command command;
+  command.type = COMMAND_DRAW_MODEL;
+  command.model = model;
+  command.bindTextures = bindTextures;
+  commands.push_back(command);
+  drawCount++;
+}
+
+void CommandList::Execute(GLuint specularIntensityLocation, GLuint shininessLocation)
+{
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    Command& command = commands[i];
+
+    switch (command.type)
+    {
+      case COMMAND_SET_DRAW:
+        DrawData::Use(command.drawID);
+        break;
+      case COMMAND_SET_MATERIAL:
+        command.material->UseMaterial(specularIntensityLocation, shininessLocation);
+        break;
+      case COMMAND_BIND_TEXTURE:
+        command.texture->UseTexture();
+        break;
+      case COMMAND_DRAW_MESH:
+        command.mesh->RenderMesh();
+        break;
+      case COMMAND_DRAW_MODEL:
+        command.model->RenderModel(command.bindTextures);
+        break;
+    }
+  }
+}
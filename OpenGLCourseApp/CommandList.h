@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Mesh.h"
+#include "Model.h"
+#include "Texture.h"
+#include "Material.h"
+
+// A pass's draws written down as plain structs instead of made straight
+// away. Recording never touches GL, so any thread can build a list; only
+// Execute makes GL calls, and that's always on the GL thread.
+//
+// Lists are reused from frame to frame, Clear keeps the memory.
+class CommandList
+{
+  public:
+    CommandList();
+
+    void Clear();
+
+    // which entry of the draw data the next draws use
+    void SetDraw(int drawID);
+    void SetMaterial(Material* material);
+    void BindTexture(Texture* texture);
+    void DrawMesh(Mesh* mesh);
+    void DrawModel(Model* model, bool bindTextures);
+
+    // replays every command in the order it was recorded. Materials are
+    // set on the locations given, from the program that's bound.
+    void Execute(GLuint specularIntensityLocation, GLuint shininessLocation);
+
+    size_t GetDrawCount() { return drawCount; }
+
+  private:
+    enum CommandType
+    {
+      COMMAND_SET_DRAW,
+      COMMAND_SET_MATERIAL,
+      COMMAND_BIND_TEXTURE,
+      COMMAND_DRAW_MESH,
+      COMMAND_DRAW_MODEL
+    };
+
+    // only the member for its type is used
+    struct Command
+    {
+      CommandType type;
+      union
+      {
+        int drawID;
+        Material* material;
+        Texture* texture;
+        Mesh* mesh;
+        Model* model;
+      };
+      bool bindTextures;
+    };
+
+    std::vector<Command> commands;
+    size_t drawCount;
+};
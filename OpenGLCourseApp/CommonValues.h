@@ -1,4 +1,39 @@
 #pragma once
 
+// These are shared with the shaders through CommonValues.glsl, any new one
+// needs adding to the list in ShaderIncludes.cpp as well.
+
 const int MAX_POINT_LIGHTS = 3;
 const int MAX_SPOT_LIGHTS = 3;
+
+// the texture unit every diffuse texture gets bound to
+const int DIFFUSE_TEXTURE_UNIT = 1;
+
+// texture handle table (see TextureTable.h)
+const int MAX_TEXTURE_HANDLES = 128;
+const int MAX_TEXTURE_ARRAYS = 5;   // one per size from 64x64 up to 1024x1024
+const int TEXTURE_ARRAY_UNIT = 9;   // first unit after the omni shadow maps
+const int TEXTURE_TABLE_BINDING = 0;
+
+// per-draw data ring (see DrawData.h)
+const int MAX_DRAWS_PER_FRAME = 128;
+const int DRAW_RING_FRAMES = 3;
+const int DRAW_DATA_BINDING = 1;
+
+// point and spot light shadows all share one depth texture (see ShadowAtlas.h)
+const int SHADOW_ATLAS_SIZE = 4096;
+const int SHADOW_ATLAS_MIN_TILE = 64;
+const int SHADOW_ATLAS_UNIT = 3;
+
+// how many shadow faces (6 a point light, 1 a spot light) get redrawn each
+// frame, and the most frames one can go without (see ShadowScheduler.h)
+const int SHADOW_FACE_BUDGET = 8;
+const int SHADOW_MAX_STALE_FRAMES = 8;
+
+// 1 gives the directional light a blurred variance shadow map, one lookup
+// per fragment. 0 keeps plain depth with PCF_RADIUS filtering.
+const int VARIANCE_SHADOWS = 1;
+
+// deferred shading reads its four G-buffer textures from here up. The light
+// passes never sample the texture arrays, so it's safe to share their units.
+const int GBUFFER_TEXTURE_UNIT = TEXTURE_ARRAY_UNIT;
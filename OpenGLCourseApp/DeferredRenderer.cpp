@@ -0,0 +1,306 @@
+#include "DeferredRenderer.h"
+
+#include <math.h>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "TextureTable.h"
+#include "UniformState.h"
+
+static const float pi = 3.14159265f;
+
+// how round the light volumes are, they only need to be a loose fit
+static const int sphereStacks = 12;
+static const int sphereSlices = 16;
+static const int coneSegments = 16;
+
+DeferredRenderer::DeferredRenderer()
+{
+  sphere = nullptr;
+  cone = nullptr;
+  emptyVAO = 0;
+}
+
+bool DeferredRenderer::Init(GLuint width, GLuint height, const std::string& textureDefines)
+{
+  if (!gBuffer.Init(width, height))
+  {
+    return false;
+  }
+
+  geometryShader.SetDefines(textureDefines);
+  geometryShader.CreateFromFiles("Shaders/gbuffer.vert", "Shaders/gbuffer.frag");
+
+  directionalShader.SetDefines("#define LIGHT_DIRECTIONAL\n");
+  directionalShader.CreateFromFiles(
+      "Shaders/deferred_fullscreen.vert",
+      "Shaders/deferred_light.frag");
+
+  pointShader.SetDefines("#define LIGHT_POINT\n");
+  pointShader.CreateFromFiles("Shaders/deferred_volume.vert", "Shaders/deferred_light.frag");
+
+  spotShader.SetDefines("#define LIGHT_SPOT\n");
+  spotShader.CreateFromFiles("Shaders/deferred_volume.vert", "Shaders/deferred_light.frag");
+
+  CreateSphere();
+  CreateCone();
+
+  glGenVertexArrays(1, &emptyVAO);
+
+  return true;
+}
+
+void DeferredRenderer::CreateSphere()
+{
+  // pushed out so the middle of every face sits on the unit sphere
+  float scale = 1.0f / (cosf(pi / sphereSlices) * cosf(pi / (2 * sphereStacks)));
+
+  std::vector<GLfloat> vertices;
+  std::vector<unsigned int> indices;
+
+  for (int i = 0; i <= sphereStacks; i++)
+  {
+    float phi = pi * i / sphereStacks;
+
+    for (int j = 0; j <= sphereSlices; j++)
+    {
+      float theta = 2.0f * pi * j / sphereSlices;
+
+      glm::vec3 normal(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+      glm::vec3 position = normal * scale;
+
+      // x, y, z, u, v, nx, ny, nz like every other mesh
+      GLfloat vertex[] = {
+        position.x, position.y, position.z,
+        (float)j / sphereSlices, (float)i / sphereStacks,
+        normal.x, normal.y, normal.z
+      };
+      vertices.insert(vertices.end(), vertex, vertex + 8);
+    }
+  }
+
+  // counter clockwise seen from outside
+  for (int i = 0; i < sphereStacks; i++)
+  {
+    for (int j = 0; j < sphereSlices; j++)
+    {
+      unsigned int a = i * (sphereSlices + 1) + j;
+      unsigned int b = a + sphereSlices + 1;
+
+      unsigned int quad[] = { a, a + 1, b, a + 1, b + 1, b };
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+
+  sphere = new Mesh();
+  sphere->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+}
+
+void DeferredRenderer::CreateCone()
+{
+  // the base ring gets the same treatment as the sphere
+  float scale = 1.0f / cosf(pi / coneSegments);
+
+  std::vector<GLfloat> vertices;
+  std::vector<unsigned int> indices;
+
+  // the tip sits on the light
+  GLfloat tip[] = { 0.0f, 0.0f, 0.0f,   0.5f, 0.0f,   0.0f, 0.0f, 1.0f };
+  vertices.insert(vertices.end(), tip, tip + 8);
+
+  for (int i = 0; i < coneSegments; i++)
+  {
+    float theta = 2.0f * pi * i / coneSegments;
+    float x = cosf(theta), y = sinf(theta);
+
+    GLfloat vertex[] = {
+      x * scale, y * scale, -1.0f,
+      (float)i / coneSegments, 1.0f,
+      x, y, 0.0f
+    };
+    vertices.insert(vertices.end(), vertex, vertex + 8);
+  }
+
+  GLfloat baseCenter[] = { 0.0f, 0.0f, -1.0f,   0.5f, 1.0f,   0.0f, 0.0f, -1.0f };
+  vertices.insert(vertices.end(), baseCenter, baseCenter + 8);
+
+  unsigned int center = coneSegments + 1;
+  for (int i = 0; i < coneSegments; i++)
+  {
+    unsigned int current = 1 + i;
+    unsigned int next = 1 + (i + 1) % coneSegments;
+
+    // one side and one slice of the base, both counter clockwise
+    unsigned int triangles[] = { 0, current, next, center, next, current };
+    indices.insert(indices.end(), triangles, triangles + 6);
+  }
+
+  cone = new Mesh();
+  cone->CreateMesh(&vertices[0], &indices[0], vertices.size(), indices.size());
+}
+
+void DeferredRenderer::BeginGeometryPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+  gBuffer.Write();
+  glViewport(0, 0, gBuffer.GetWidth(), gBuffer.GetHeight());
+
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  geometryShader.UseShader();
+
+  UniformState::SetMatrix4fv(geometryShader.GetProjectionLocation(), glm::value_ptr(projectionMatrix));
+  UniformState::SetMatrix4fv(geometryShader.GetViewLocation(), glm::value_ptr(viewMatrix));
+
+  geometryShader.SetTexture(DIFFUSE_TEXTURE_UNIT);
+  TextureTable::Bind();
+
+  geometryShader.Validate();
+}
+
+void DeferredRenderer::EndGeometryPass()
+{
+  // unbind
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DeferredRenderer::UseLightShader(Shader* shader, glm::mat4& viewMatrix,
+    glm::mat4& projectionMatrix, glm::vec3& eyePosition)
+{
+  shader->UseShader();
+
+  UniformState::SetMatrix4fv(shader->GetProjectionLocation(), glm::value_ptr(projectionMatrix));
+  UniformState::SetMatrix4fv(shader->GetViewLocation(), glm::value_ptr(viewMatrix));
+  UniformState::SetMatrix4fv(shader->GetUniformLocation(UNIFORM_ID("inverseViewProjection")),
+      glm::value_ptr(inverseViewProjection));
+  UniformState::Set2f(shader->GetUniformLocation(UNIFORM_ID("screenSize")),
+      (GLfloat)gBuffer.GetWidth(), (GLfloat)gBuffer.GetHeight());
+  UniformState::Set3f(shader->GetEyePositionLocation(), eyePosition.x, eyePosition.y, eyePosition.z);
+
+  UniformState::Set1i(shader->GetUniformLocation(UNIFORM_ID("gAlbedo")), GBUFFER_TEXTURE_UNIT);
+  UniformState::Set1i(shader->GetUniformLocation(UNIFORM_ID("gNormal")), GBUFFER_TEXTURE_UNIT + 1);
+  UniformState::Set1i(shader->GetUniformLocation(UNIFORM_ID("gMaterial")), GBUFFER_TEXTURE_UNIT + 2);
+  UniformState::Set1i(shader->GetUniformLocation(UNIFORM_ID("gDepth")), GBUFFER_TEXTURE_UNIT + 3);
+
+  // bound by main along with the directional shadow map
+  shader->SetShadowAtlas(SHADOW_ATLAS_UNIT);
+}
+
+void DeferredRenderer::LightingPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix,
+    glm::vec3 eyePosition,
+    DirectionalLight* dLight,
+    PointLight* pLights, unsigned int pointLightCount,
+    SpotLight* sLights, unsigned int spotLightCount)
+{
+  inverseViewProjection = glm::inverse(projectionMatrix * viewMatrix);
+
+  gBuffer.BeginLighting();
+  gBuffer.Read(GBUFFER_TEXTURE_UNIT);
+  glViewport(0, 0, gBuffer.GetWidth(), gBuffer.GetHeight());
+
+  // every light adds on top of the last
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+  glDepthMask(GL_FALSE);
+
+  // the directional light reaches every pixel
+  glDisable(GL_DEPTH_TEST);
+
+  UseLightShader(&directionalShader, viewMatrix, projectionMatrix, eyePosition);
+  directionalShader.SetDirectionalLight(dLight);
+
+  glm::mat4 lightTransform = dLight->CalculateLightTransform();
+  directionalShader.SetDirectionalLightTransform(&lightTransform);
+  dLight->GetShadowMap()->Read(GL_TEXTURE2);
+  directionalShader.SetDirectionalShadowMap(2);
+
+  directionalShader.Validate();
+
+  glBindVertexArray(emptyVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  // Volumes draw their back faces, and only where the scene is in front of
+  // them. That skips pixels behind the light, and still works with the
+  // camera inside the volume. Depth clamp keeps back faces past the far
+  // plane from being clipped away.
+  glEnable(GL_DEPTH_TEST);
+  glDepthFunc(GL_GEQUAL);
+  glEnable(GL_DEPTH_CLAMP);
+  glEnable(GL_CULL_FACE);
+  glCullFace(GL_FRONT);
+
+  GLint lightModelLocation;
+
+  for (unsigned int i = 0; i < pointLightCount; i++)
+  {
+    UseLightShader(&pointShader, viewMatrix, projectionMatrix, eyePosition);
+    pointShader.SetPointLights(&pLights[i], 1, 0);
+
+    glm::mat4 lightModel = glm::translate(glm::mat4(1.0f), pLights[i].GetPosition());
+    lightModel = glm::scale(lightModel, glm::vec3(pLights[i].GetRange()));
+
+    lightModelLocation = pointShader.GetUniformLocation(UNIFORM_ID("lightModel"));
+    UniformState::SetMatrix4fv(lightModelLocation, glm::value_ptr(lightModel));
+
+    sphere->RenderMesh();
+  }
+
+  for (unsigned int i = 0; i < spotLightCount; i++)
+  {
+    UseLightShader(&spotShader, viewMatrix, projectionMatrix, eyePosition);
+    spotShader.SetSpotLights(&sLights[i], 1, 0);
+
+    glm::vec3 position = sLights[i].GetPosition();
+    glm::vec3 direction = sLights[i].GetDirection();
+    GLfloat range = sLights[i].GetRange();
+    GLfloat edge = sLights[i].GetEdge();
+
+    lightModelLocation = spotShader.GetUniformLocation(UNIFORM_ID("lightModel"));
+
+    // 90 degrees or wider and a cone doesn't fit, use a sphere
+    if (edge <= 0.0f)
+    {
+      glm::mat4 lightModel = glm::translate(glm::mat4(1.0f), position);
+      lightModel = glm::scale(lightModel, glm::vec3(range));
+
+      UniformState::SetMatrix4fv(lightModelLocation, glm::value_ptr(lightModel));
+      sphere->RenderMesh();
+      continue;
+    }
+
+    // lookAt builds a view looking down -z, the inverse turns the cone's
+    // -z towards the light's direction
+    glm::vec3 up = fabsf(direction.y) > 0.99f ?
+      glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    GLfloat radius = range * sqrtf(1.0f - edge * edge) / edge;
+
+    glm::mat4 lightModel = glm::inverse(glm::lookAt(position, position + direction, up));
+    lightModel = glm::scale(lightModel, glm::vec3(radius, radius, range));
+
+    UniformState::SetMatrix4fv(lightModelLocation, glm::value_ptr(lightModel));
+    cone->RenderMesh();
+  }
+
+  glCullFace(GL_BACK);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_DEPTH_CLAMP);
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+
+  gBuffer.Present();
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+  delete sphere;
+  delete cone;
+
+  if (emptyVAO)
+  {
+    glDeleteVertexArrays(1, &emptyVAO);
+  }
+}
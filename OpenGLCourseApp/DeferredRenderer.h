@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "GBuffer.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+
+// The alternative to shading everything in shader.frag. The scene gets
+// drawn once into a G-buffer, then each light only runs over the pixels
+// it can reach: a sphere around a point light, a cone for a spot light and
+// the whole screen for the directional light. Lighting cost goes with how
+// many pixels are lit, not with how much geometry there is.
+class DeferredRenderer
+{
+  public:
+    DeferredRenderer();
+
+    // textureDefines is TextureTable::GetShaderDefines(), the geometry pass
+    // samples the diffuse textures the same way the forward shader does
+    bool Init(GLuint width, GLuint height, const std::string& textureDefines);
+
+    // binds the G-buffer and its shader, then draw the scene as usual
+    void BeginGeometryPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
+    void EndGeometryPass();
+
+    // adds up every light into the window
+    void LightingPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix,
+        glm::vec3 eyePosition,
+        DirectionalLight* dLight,
+        PointLight* pLights, unsigned int pointLightCount,
+        SpotLight* sLights, unsigned int spotLightCount);
+
+    Shader* GetGeometryShader() { return &geometryShader; }
+
+    ~DeferredRenderer();
+
+  private:
+    GBuffer gBuffer;
+
+    Shader geometryShader;
+    Shader directionalShader;
+    Shader pointShader;
+    Shader spotShader;
+
+    // unit sphere and a unit cone pointing down -z, both a little oversized
+    // so the flat faces never cut into the real shape
+    Mesh* sphere;
+    Mesh* cone;
+
+    // the full screen triangle has no vertex data, but GL still wants a VAO
+    GLuint emptyVAO;
+
+    glm::mat4 inverseViewProjection;
+
+    void CreateSphere();
+    void CreateCone();
+
+    void UseLightShader(Shader* shader, glm::mat4& viewMatrix,
+        glm::mat4& projectionMatrix, glm::vec3& eyePosition);
+};
@@ -1,19 +1,38 @@
 #include "DirectionalLight.h"
 
+#include "UniformState.h"
+#include "VarianceShadowMap.h"
+
 DirectionalLight::DirectionalLight() : Light()
 {
   direction = glm::vec3(0.0f, -1.0f, 0.0f);
-  lightProj = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 20.0f);
+  shadowDepth = 20.0f;
+  baseShadowWidth = 0;
+  baseShadowHeight = 0;
+  lightProj = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, shadowDepth);
 }
 
 DirectionalLight::DirectionalLight(GLfloat shadowWidth, GLfloat shadowHeight,
     GLfloat red, GLfloat green, GLfloat blue,
     GLfloat aIntensity, GLfloat dIntensity,
     GLfloat xDir, GLfloat yDir, GLfloat zDir) :
-  Light(shadowWidth, shadowHeight, red, green, blue, aIntensity, dIntensity)
+  Light(red, green, blue, aIntensity, dIntensity)
 {
+  if (VARIANCE_SHADOWS)
+  {
+    shadowMap = new VarianceShadowMap();
+  }
+  else
+  {
+    shadowMap = new ShadowMap();
+  }
+  baseShadowWidth = shadowWidth;
+  baseShadowHeight = shadowHeight;
+  SetShadowQuality(ShadowQuality::Get(ShadowQuality::defaultTier));
+
   direction = glm::vec3(xDir, yDir, zDir);
-  lightProj = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, 0.01f, 100.0f);
+  shadowDepth = 100.0f;
+  lightProj = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, 0.01f, shadowDepth);
 }
 
 void DirectionalLight::UseLight(GLuint ambientIntensityLocation,
@@ -21,11 +40,24 @@ void DirectionalLight::UseLight(GLuint ambientIntensityLocation,
     GLuint diffuseIntensityLocation,
     GLuint directionLocation)
 {
-  glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-  glUniform1f(ambientIntensityLocation, ambientIntensity);
+  UniformState::Set3f(ambientColorLocation, color.x, color.y, color.z);
+  UniformState::Set1f(ambientIntensityLocation, ambientIntensity);
+
+  UniformState::Set3f(directionLocation, direction.x, direction.y, direction.z);
+  UniformState::Set1f(diffuseIntensityLocation, diffuseIntensity);
+}
+
+void DirectionalLight::SetShadowQuality(const ShadowQuality& quality)
+{
+  if (!shadowMap)
+  {
+    return;
+  }
 
-  glUniform3f(directionLocation, direction.x, direction.y, direction.z);
-  glUniform1f(diffuseIntensityLocation, diffuseIntensity);
+  shadowMap->Init(
+      (GLuint)(baseShadowWidth * quality.scale),
+      (GLuint)(baseShadowHeight * quality.scale),
+      quality.directionalFormat);
 }
 
 glm::mat4 DirectionalLight::CalculateLightTransform()
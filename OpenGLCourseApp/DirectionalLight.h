@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Light.h"
+#include "ShadowQuality.h"
 class DirectionalLight : public Light
 {
   public:
@@ -18,8 +19,20 @@ class DirectionalLight : public Light
 
     glm::mat4 CalculateLightTransform();
 
+    // rebuilds the shadow map at the tier's size and format
+    void SetShadowQuality(const ShadowQuality& quality);
+
+    glm::vec3 GetDirection() { return direction; }
+    // how far the ortho box reaches along the direction, as far as any
+    // shadow can fall
+    GLfloat GetShadowDepth() { return shadowDepth; }
+
     ~DirectionalLight();
 
   private:
     glm::vec3 direction;
+    GLfloat shadowDepth;
+
+    // the size it was made with, before any quality scaling
+    GLuint baseShadowWidth, baseShadowHeight;
 };
@@ -0,0 +1,193 @@
+#include "DrawData.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "UniformState.h"
+
+#if defined(__SSE2__)
+#define DRAW_DATA_SIMD
+#include <emmintrin.h>
+#endif
+
+GLuint DrawData::buffer = 0;
+GLintptr DrawData::sectionSize = 0;
+int DrawData::section = 0;
+GLsync DrawData::fences[DRAW_RING_FRAMES] = { 0 };
+
+std::vector<DrawData::Entry> DrawData::entries;
+GLint DrawData::idLocation = -1;
+
+bool DrawData::Init()
+{
+  ClearDrawData();
+
+  // every section has to start on an offset glBindBufferRange accepts
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+  sectionSize = sizeof(Entry) * MAX_DRAWS_PER_FRAME;
+  sectionSize = (sectionSize + alignment - 1) / alignment * alignment;
+
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, sectionSize * DRAW_RING_FRAMES, nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  entries.reserve(MAX_DRAWS_PER_FRAME);
+  return buffer != 0;
+}
+
+void DrawData::BeginFrame()
+{
+  section = (section + 1) % DRAW_RING_FRAMES;
+  entries.clear();
+
+  // only waits if we're a whole ring ahead of the GPU
+  if (fences[section])
+  {
+    glClientWaitSync(fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(fences[section]);
+    fences[section] = 0;
+  }
+}
+
+int DrawData::Add(const glm::mat4& model, GLfloat specularIntensity, GLfloat shininess)
+{
+  if (entries.size() >= (size_t)MAX_DRAWS_PER_FRAME)
+  {
+    printf("Too many draws this frame, the limit is %d\n", MAX_DRAWS_PER_FRAME);
+    return -1;
+  }
+
+  Entry entry;
+  entry.model = model;
+  entry.material = glm::vec4(specularIntensity, shininess, 0.0f, 0.0f);
+  entries.push_back(entry);
+
+  return (int)entries.size() - 1;
+}
+
+#ifdef DRAW_DATA_SIMD
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+  // a.yzx * b.zxy - a.zxy * b.yzx, with one less shuffle
+  __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+  return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+#endif
+
+// The normal matrix is the inverse transpose of the model's upper 3x3. The
+// shaders normalize normals anyway, so the cofactor matrix (the inverse
+// transpose times the determinant) does the same job without a divide. Its
+// columns are just cross products of the model's columns. For rotations
+// and uniform scales it works out to the model's 3x3 times a constant.
+void DrawData::ComputeNormalMatrices()
+{
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    Entry& entry = entries[i];
+
+#ifdef DRAW_DATA_SIMD
+    // w of the first three columns is 0 in any affine transform, and the
+    // cross products keep it that way
+    __m128 x = _mm_loadu_ps(&entry.model[0][0]);
+    __m128 y = _mm_loadu_ps(&entry.model[1][0]);
+    __m128 z = _mm_loadu_ps(&entry.model[2][0]);
+
+    __m128 cx = Cross(y, z);
+    __m128 cy = Cross(z, x);
+    __m128 cz = Cross(x, y);
+
+    // a mirrored transform has a negative determinant, which would turn
+    // every normal inside out
+    __m128 det = _mm_mul_ps(x, cx);
+    float d = _mm_cvtss_f32(det) +
+      _mm_cvtss_f32(_mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 1, 1, 1))) +
+      _mm_cvtss_f32(_mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 2, 2, 2)));
+    __m128 sign = _mm_set1_ps(d < 0.0f ? -1.0f : 1.0f);
+
+    _mm_storeu_ps(&entry.normal[0][0], _mm_mul_ps(cx, sign));
+    _mm_storeu_ps(&entry.normal[1][0], _mm_mul_ps(cy, sign));
+    _mm_storeu_ps(&entry.normal[2][0], _mm_mul_ps(cz, sign));
+#else
+    glm::vec3 x(entry.model[0]), y(entry.model[1]), z(entry.model[2]);
+    glm::vec3 cx = glm::cross(y, z), cy = glm::cross(z, x), cz = glm::cross(x, y);
+    float sign = glm::dot(x, cx) < 0.0f ? -1.0f : 1.0f;
+
+    entry.normal[0] = glm::vec4(cx * sign, 0.0f);
+    entry.normal[1] = glm::vec4(cy * sign, 0.0f);
+    entry.normal[2] = glm::vec4(cz * sign, 0.0f);
+#endif
+  }
+}
+
+void DrawData::Upload()
+{
+  if (!buffer || entries.empty())
+  {
+    return;
+  }
+
+  // every object's normal matrix in one pass, instead of once per vertex
+  ComputeNormalMatrices();
+
+  GLintptr offset = sectionSize * section;
+  GLsizeiptr size = sizeof(Entry) * entries.size();
+
+  // the fence in BeginFrame already made sure the GPU is done with this
+  // section, so there's no need for the driver to check again
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  void* data = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+  if (data)
+  {
+    memcpy(data, &entries[0], size);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+  }
+  else
+  {
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, &entries[0]);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  glBindBufferRange(GL_UNIFORM_BUFFER, DRAW_DATA_BINDING, buffer,
+      offset, sizeof(Entry) * MAX_DRAWS_PER_FRAME);
+}
+
+void DrawData::EndFrame()
+{
+  if (buffer)
+  {
+    fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+void DrawData::Use(int drawID)
+{
+  UniformState::Set1i(idLocation, drawID);
+}
+
+void DrawData::ClearDrawData()
+{
+  for (int i = 0; i < DRAW_RING_FRAMES; i++)
+  {
+    if (fences[i])
+    {
+      glDeleteSync(fences[i]);
+      fences[i] = 0;
+    }
+  }
+
+  if (buffer)
+  {
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+  }
+
+  entries.clear();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+
+// Everything that changes from one draw to the next (model matrix and
+// material) lives in one uniform buffer, written once a frame. Each draw
+// then only has to set its index into it, the drawID uniform.
+//
+// The buffer is a ring of DRAW_RING_FRAMES sections so we never write over
+// data the GPU may still be reading from an earlier frame.
+class DrawData
+{
+  public:
+    static bool Init();
+
+    // moves on to the next section of the ring and empties the draw list
+    static void BeginFrame();
+
+    // returns the drawID to pass to Use, -1 once the frame is full
+    static int Add(const glm::mat4& model, GLfloat specularIntensity, GLfloat shininess);
+
+    // copies every draw added this frame to the GPU and binds it
+    static void Upload();
+    static void EndFrame();
+
+    // set by Shader::UseShader, like the texture table index
+    static void SetIDLocation(GLint location) { idLocation = location; }
+    static void Use(int drawID);
+
+    static void ClearDrawData();
+
+  private:
+    // matches the std140 layout of DrawData in the shaders. 128 bytes, so a
+    // full frame just fits in the 16KB every driver allows for a block.
+    struct Entry
+    {
+      glm::mat4 model;
+      glm::vec4 normal[3]; // mat3 in std140, each column padded to a vec4
+      glm::vec4 material;  // x = specular intensity, y = shininess
+    };
+
+    static void ComputeNormalMatrices();
+
+    static GLuint buffer;
+    static GLintptr sectionSize;
+    static int section;
+    static GLsync fences[DRAW_RING_FRAMES];
+
+    static std::vector<Entry> entries;
+    static GLint idLocation;
+};
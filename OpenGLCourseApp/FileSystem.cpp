@@ -0,0 +1,248 @@
+#include "FileSystem.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+const unsigned char* FileSystem::packData = nullptr;
+size_t FileSystem::packSize = 0;
+
+AssetFile::AssetFile()
+{
+  mapped = nullptr;
+  size = 0;
+}
+
+bool FileSystem::Mount(const char* packLocation)
+{
+  Unmount();
+
+  int fd = open(packLocation, O_RDONLY);
+  if (fd < 0)
+  {
+    printf("No asset pack at %s, using loose files\n", packLocation);
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AssetPackHeader))
+  {
+    printf("Asset pack %s is too small\n", packLocation);
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file alive, we don't need the descriptor anymore
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    printf("Failed to map asset pack %s\n", packLocation);
+    return false;
+  }
+
+  const AssetPackHeader* header = (const AssetPackHeader*)data;
+  size_t fileSize = info.st_size;
+
+  bool valid = memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) == 0 &&
+    header->version == ASSET_PACK_VERSION &&
+    header->tocOffset <= fileSize &&
+    (size_t)header->entryCount <= (fileSize - header->tocOffset) / sizeof(AssetPackEntry) &&
+    header->namesOffset <= fileSize;
+
+  // FindEntry reads the names straight out of the mapping, so every one of
+  // them has to be inside it. Checked once here rather than on each lookup.
+  if (valid)
+  {
+    const AssetPackEntry* entries = (const AssetPackEntry*)((const unsigned char*)data + header->tocOffset);
+    size_t namesSize = fileSize - header->namesOffset;
+
+    for (size_t i = 0; i < header->entryCount && valid; i++)
+    {
+      valid = entries[i].nameOffset <= namesSize &&
+        entries[i].nameLength <= namesSize - entries[i].nameOffset;
+    }
+  }
+
+  if (!valid)
+  {
+    printf("%s isn't a valid asset pack\n", packLocation);
+    munmap(data, info.st_size);
+    return false;
+  }
+
+  // everything in the pack gets used during startup, so ask the kernel to
+  // start reading all of it in now with big sequential reads
+  madvise(data, info.st_size, MADV_WILLNEED);
+
+  packData = (const unsigned char*)data;
+  packSize = info.st_size;
+
+  printf("Mounted asset pack %s (%u files)\n", packLocation, header->entryCount);
+  return true;
+}
+
+void FileSystem::Unmount()
+{
+  if (packData)
+  {
+    munmap((void*)packData, packSize);
+    packData = nullptr;
+    packSize = 0;
+  }
+}
+
+const AssetPackEntry* FileSystem::FindEntry(const char* fileLocation)
+{
+  if (!packData)
+  {
+    return nullptr;
+  }
+
+  const AssetPackHeader* header = (const AssetPackHeader*)packData;
+  const AssetPackEntry* entries = (const AssetPackEntry*)(packData + header->tocOffset);
+  const char* names = (const char*)(packData + header->namesOffset);
+
+  // "./Shaders/x" and "Shaders/x" are the same file
+  while (fileLocation[0] == '.' && (fileLocation[1] == '/' || fileLocation[1] == '\\'))
+  {
+    fileLocation += 2;
+  }
+
+  size_t length = strlen(fileLocation);
+  uint32_t hash = HashAssetPath(fileLocation, length);
+
+  // the table is sorted by hash, so find the first entry with ours
+  size_t low = 0, high = header->entryCount;
+  while (low < high)
+  {
+    size_t mid = (low + high) / 2;
+    if (entries[mid].hash < hash)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+
+  // then check the names in case more than one path has the same hash
+  for (size_t i = low; i < header->entryCount && entries[i].hash == hash; i++)
+  {
+    if (entries[i].nameLength != length)
+    {
+      continue;
+    }
+
+    const char* name = names + entries[i].nameOffset;
+    bool match = true;
+    for (size_t c = 0; c < length && match; c++)
+    {
+      char a = fileLocation[c] == '\\' ? '/' : fileLocation[c];
+      match = a == name[c];
+    }
+
+    if (match)
+    {
+      return &entries[i];
+    }
+  }
+
+  return nullptr;
+}
+
+bool FileSystem::ReadFile(const char* fileLocation, AssetFile& file)
+{
+  file.mapped = nullptr;
+  file.buffer.clear();
+  file.size = 0;
+
+  const AssetPackEntry* entry = FindEntry(fileLocation);
+  if (!entry)
+  {
+    return ReadLooseFile(fileLocation, file);
+  }
+
+  if (entry->offset > packSize || entry->storedSize > packSize - entry->offset)
+  {
+    printf("Asset pack entry for %s is out of bounds\n", fileLocation);
+    return false;
+  }
+
+  // an uncompressed entry is handed out as it is in the pack, so its size
+  // can't be any bigger than what's stored
+  if (!(entry->flags & ASSET_ENTRY_LZ4) && entry->size != entry->storedSize)
+  {
+    printf("Asset pack entry for %s has the wrong size\n", fileLocation);
+    return false;
+  }
+
+  const unsigned char* payload = packData + entry->offset;
+
+  if (entry->flags & ASSET_ENTRY_LZ4)
+  {
+#ifdef USE_LZ4
+    file.buffer.resize(entry->size);
+    int read = LZ4_decompress_safe((const char*)payload, (char*)&file.buffer[0],
+        (int)entry->storedSize, (int)entry->size);
+
+    if (read < 0 || (uint64_t)read != entry->size)
+    {
+      printf("Failed to decompress %s from the asset pack\n", fileLocation);
+      file.buffer.clear();
+      return false;
+    }
+#else
+    printf("%s is LZ4 compressed, rebuild with LZ4=1 to read it\n", fileLocation);
+    return false;
+#endif
+  }
+  else
+  {
+    // no copy, just point at the mapped pack
+    file.mapped = payload;
+  }
+
+  file.size = entry->size;
+  return true;
+}
+
+bool FileSystem::ReadLooseFile(const char* fileLocation, AssetFile& file)
+{
+  FILE* stream = fopen(fileLocation, "rb");
+  if (!stream)
+  {
+    return false;
+  }
+
+  fseek(stream, 0, SEEK_END);
+  long length = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+
+  if (length > 0)
+  {
+    file.buffer.resize(length);
+    file.size = fread(&file.buffer[0], 1, length, stream);
+  }
+
+  fclose(stream);
+  return file.size == (size_t)(length > 0 ? length : 0);
+}
+
+bool FileSystem::Exists(const char* fileLocation)
+{
+  if (FindEntry(fileLocation))
+  {
+    return true;
+  }
+
+  struct stat info;
+  return stat(fileLocation, &info) == 0 && S_ISREG(info.st_mode);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+
+// The contents of one file. When it comes straight out of an uncompressed
+// pack entry this just points into the mapped pack, no copy is made.
+class AssetFile
+{
+  public:
+    AssetFile();
+
+    const unsigned char* GetData() const { return mapped ? mapped : (buffer.empty() ? nullptr : &buffer[0]); }
+    size_t GetSize() const { return size; }
+
+    std::string GetString() const { return std::string((const char*)GetData(), size); }
+
+  private:
+    friend class FileSystem;
+
+    const unsigned char* mapped;
+    std::vector<unsigned char> buffer;
+    size_t size;
+};
+
+// Every asset the app loads goes through here. Files are read out of the
+// mounted pack when they're in it, otherwise straight from disk, so loose
+// files still work while developing.
+class FileSystem
+{
+  public:
+    // maps the whole pack into memory, safe to call before any OpenGL setup
+    static bool Mount(const char* packLocation);
+    static void Unmount();
+    static bool IsMounted() { return packData != nullptr; }
+
+    // thread safe once the pack is mounted
+    static bool ReadFile(const char* fileLocation, AssetFile& file);
+    static bool Exists(const char* fileLocation);
+
+    // skips the pack and reads whatever is on disk right now, for hot reloading
+    static bool ReadLooseFile(const char* fileLocation, AssetFile& file);
+
+  private:
+    static const unsigned char* packData;
+    static size_t packSize;
+
+    static const AssetPackEntry* FindEntry(const char* fileLocation);
+};
@@ -0,0 +1,65 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+{
+  // nothing gets culled by an empty one
+  for (int i = 0; i < 6; i++)
+  {
+    planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+  // each plane is the last row plus or minus one of the others. glm is
+  // column major, so row i is m[0][i], m[1][i], ...
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; i++)
+  {
+    rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i],
+        viewProjection[2][i], viewProjection[3][i]);
+  }
+
+  planes[0] = rows[3] + rows[0]; // left
+  planes[1] = rows[3] - rows[0]; // right
+  planes[2] = rows[3] + rows[1]; // bottom
+  planes[3] = rows[3] - rows[1]; // top
+  planes[4] = rows[3] + rows[2]; // near
+  planes[5] = rows[3] - rows[2]; // far
+
+  // so the distances come out in world units, to compare with a radius
+  for (int i = 0; i < 6; i++)
+  {
+    planes[i] /= glm::length(glm::vec3(planes[i]));
+  }
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, GLfloat radius) const
+{
+  for (int i = 0; i < 6; i++)
+  {
+    if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Frustum::IntersectsSweptSphere(const glm::vec3& start, const glm::vec3& end, GLfloat radius) const
+{
+  // only out if both ends are behind the same plane, the whole sweep is
+  // then behind it too
+  for (int i = 0; i < 6; i++)
+  {
+    glm::vec3 normal = glm::vec3(planes[i]);
+    if (glm::dot(normal, start) + planes[i].w < -radius &&
+        glm::dot(normal, end) + planes[i].w < -radius)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+// The six planes of a view projection, for throwing away objects before
+// they're drawn. Works the same for the camera, a light's ortho box or one
+// face of a point light.
+//
+// Every test is conservative, something reported as inside may still end
+// up drawing nothing, but nothing reported outside could have been seen.
+class Frustum
+{
+  public:
+    Frustum();
+    Frustum(const glm::mat4& viewProjection);
+
+    bool IntersectsSphere(const glm::vec3& center, GLfloat radius) const;
+
+    // everything a sphere touches moving in a straight line from start to
+    // end. Used for where a shadow can land.
+    bool IntersectsSweptSphere(const glm::vec3& start, const glm::vec3& end, GLfloat radius) const;
+
+  private:
+    // xyz is the normal pointing in, w the distance, all normalized
+    glm::vec4 planes[6];
+};
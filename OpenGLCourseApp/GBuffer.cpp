@@ -0,0 +1,156 @@
+#include "GBuffer.h"
+
+GBuffer::GBuffer()
+{
+  FBO = 0;
+  albedoMap = 0;
+  normalMap = 0;
+  materialMap = 0;
+  depthMap = 0;
+
+  lightFBO = 0;
+  lightColor = 0;
+  lightDepth = 0;
+
+  width = 0;
+  height = 0;
+}
+
+GLuint GBuffer::CreateTarget(GLenum internalFormat, GLenum format, GLenum type)
+{
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+
+  // only ever read with texelFetch, but the texture still has to be complete
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return texture;
+}
+
+bool GBuffer::CheckStatus(const char* name)
+{
+  GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    printf("%s Framebuffer Error: %i\n", name, status);
+    return false;
+  }
+
+  return true;
+}
+
+bool GBuffer::Init(GLuint bufferWidth, GLuint bufferHeight)
+{
+  width = bufferWidth;
+  height = bufferHeight;
+
+  albedoMap = CreateTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+  normalMap = CreateTarget(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+  materialMap = CreateTarget(GL_RG16F, GL_RG, GL_FLOAT);
+  depthMap = CreateTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
+
+  glGenFramebuffers(1, &FBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoMap, 0);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalMap, 0);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, materialMap, 0);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+
+  GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+  glDrawBuffers(3, drawBuffers);
+
+  if (!CheckStatus("G-Buffer"))
+  {
+    return false;
+  }
+
+  // the depth copy has to be the exact same format for the blit to work
+  glGenRenderbuffers(1, &lightColor);
+  glBindRenderbuffer(GL_RENDERBUFFER, lightColor);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &lightDepth);
+  glBindRenderbuffer(GL_RENDERBUFFER, lightDepth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+  glGenFramebuffers(1, &lightFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lightFBO);
+  glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, lightColor);
+  glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, lightDepth);
+
+  if (!CheckStatus("Lighting"))
+  {
+    return false;
+  }
+
+  // unbind framebuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  return true;
+}
+
+void GBuffer::Write()
+{
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+}
+
+void GBuffer::BeginLighting()
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lightFBO);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GBuffer::Read(GLuint firstUnit)
+{
+  GLuint maps[] = { albedoMap, normalMap, materialMap, depthMap };
+
+  for (GLuint i = 0; i < 4; i++)
+  {
+    glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+    glBindTexture(GL_TEXTURE_2D, maps[i]);
+
+    // these units are shared with the texture arrays, whose sampler would
+    // otherwise make our single level textures incomplete
+    glBindSampler(firstUnit + i, 0);
+  }
+}
+
+void GBuffer::Present()
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, lightFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+  // unbind framebuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GBuffer::~GBuffer()
+{
+  if (FBO)
+  {
+    glDeleteFramebuffers(1, &FBO);
+  }
+
+  if (lightFBO)
+  {
+    glDeleteFramebuffers(1, &lightFBO);
+  }
+
+  GLuint textures[] = { albedoMap, normalMap, materialMap, depthMap };
+  glDeleteTextures(4, textures);
+
+  GLuint renderbuffers[] = { lightColor, lightDepth };
+  glDeleteRenderbuffers(2, renderbuffers);
+}
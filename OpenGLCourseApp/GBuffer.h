@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdio.h>
+#include <GL/glew.h>
+
+// The surface attributes the deferred lighting passes read back:
+//   albedo   - rgba8, the diffuse texture
+//   normal   - rgba16f, world space normal in xyz
+//   material - rg16f, specular intensity and shininess
+//   depth    - 24 bit, world positions get rebuilt from it
+//
+// Lighting goes into a second framebuffer that shares a copy of the depth,
+// so the light volumes can be depth tested against the scene without
+// reading from a texture they're also drawing into.
+class GBuffer
+{
+  public:
+    GBuffer();
+
+    bool Init(GLuint width, GLuint height);
+
+    // bind for the geometry pass
+    void Write();
+
+    // copy the depth over and bind the lighting target, cleared to black
+    void BeginLighting();
+
+    // albedo, normal, material and depth on four units from firstUnit
+    void Read(GLuint firstUnit);
+
+    // lighting result onto the window
+    void Present();
+
+    GLuint GetWidth() { return width; }
+    GLuint GetHeight() { return height; }
+
+    ~GBuffer();
+
+  private:
+    GLuint FBO, albedoMap, normalMap, materialMap, depthMap;
+    GLuint lightFBO, lightColor, lightDepth;
+    GLuint width, height;
+
+    GLuint CreateTarget(GLenum internalFormat, GLenum format, GLenum type);
+    bool CheckStatus(const char* name);
+};
@@ -0,0 +1,550 @@
+#include "Image.h"
+
+#ifdef USE_LIBJPEG_TURBO
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+
+#ifdef USE_LIBPNG
+#include <png.h>
+#endif
+
+// The SIMD kernels are picked at runtime so the same binary still runs on
+// machines without AVX2. Anything that isn't x86 just uses the scalar loops.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Channel expansion (RGB -> RGBA)
+// ----------------------------------------------------------------------------
+
+static void ExpandRGBScalar(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+  for (size_t i = 0; i < pixels; i++)
+  {
+    dst[i * 4] = src[i * 3];
+    dst[i * 4 + 1] = src[i * 3 + 1];
+    dst[i * 4 + 2] = src[i * 3 + 2];
+    dst[i * 4 + 3] = 255;
+  }
+}
+
+#ifdef IMAGE_SIMD_X86
+__attribute__((target("ssse3")))
+static void ExpandRGBSSSE3(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+  // spread 4 rgb pixels (12 bytes) out over 16 bytes, leaving a gap for alpha
+  const __m128i shuffle = _mm_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+  // each load reads 16 bytes but only uses 12 of them, so stop early enough
+  // that the last load can't run off the end of the source
+  size_t i = 0;
+  for (; i + 6 <= pixels; i += 4)
+  {
+    __m128i rgb = _mm_loadu_si128((const __m128i*)(src + i * 3));
+    __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+    _mm_storeu_si128((__m128i*)(dst + i * 4), rgba);
+  }
+
+  ExpandRGBScalar(src + i * 3, dst + i * 4, pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void ExpandRGBAVX2(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+  // same as the SSSE3 version, but the shuffle works on each 128-bit lane so
+  // we load 4 pixels into each half of the register
+  const __m256i shuffle = _mm256_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+  size_t i = 0;
+  for (; i + 10 <= pixels; i += 8)
+  {
+    __m128i lo = _mm_loadu_si128((const __m128i*)(src + i * 3));
+    __m128i hi = _mm_loadu_si128((const __m128i*)(src + i * 3 + 12));
+    __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha);
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), rgba);
+  }
+
+  ExpandRGBScalar(src + i * 3, dst + i * 4, pixels - i);
+}
+#endif
+
+static void ExpandRGB(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+#ifdef IMAGE_SIMD_X86
+  if (__builtin_cpu_supports("avx2"))
+  {
+    ExpandRGBAVX2(src, dst, pixels);
+    return;
+  }
+
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    ExpandRGBSSSE3(src, dst, pixels);
+    return;
+  }
+#endif
+
+  ExpandRGBScalar(src, dst, pixels);
+}
+
+// ----------------------------------------------------------------------------
+// Vertical flip
+// ----------------------------------------------------------------------------
+
+static void SwapRows(unsigned char* a, unsigned char* b, size_t rowSize)
+{
+  size_t i = 0;
+
+#if defined(IMAGE_SIMD_X86) && defined(__SSE2__)
+  // flipping is bound by memory bandwidth, so 16 bytes at a time is plenty
+  for (; i + 16 <= rowSize; i += 16)
+  {
+    __m128i rowA = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i rowB = _mm_loadu_si128((const __m128i*)(b + i));
+    _mm_storeu_si128((__m128i*)(a + i), rowB);
+    _mm_storeu_si128((__m128i*)(b + i), rowA);
+  }
+#endif
+
+  for (; i < rowSize; i++)
+  {
+    unsigned char temp = a[i];
+    a[i] = b[i];
+    b[i] = temp;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Alpha premultiplication
+// ----------------------------------------------------------------------------
+
+static void PremultiplyScalar(unsigned char* pixels, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    unsigned int alpha = pixels[i * 4 + 3];
+    for (size_t c = 0; c < 3; c++)
+    {
+      // (t + (t >> 8)) >> 8 is an exact x * a / 255 for 8-bit values
+      unsigned int t = pixels[i * 4 + c] * alpha + 128;
+      pixels[i * 4 + c] = (unsigned char)((t + (t >> 8)) >> 8);
+    }
+  }
+}
+
+#ifdef IMAGE_SIMD_X86
+__attribute__((target("sse2")))
+static void PremultiplySSE2(unsigned char* pixels, size_t count)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi16(128);
+  // the alpha lanes are multiplied by 255 instead, which leaves them as is
+  const __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+  const __m128i alphaOne = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i px = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+
+    // widen to 16 bits so the multiply doesn't overflow, 2 pixels per half
+    __m128i halves[2] = { _mm_unpacklo_epi8(px, zero), _mm_unpackhi_epi8(px, zero) };
+    for (int h = 0; h < 2; h++)
+    {
+      __m128i a = _mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alphaOne);
+
+      __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], a), round);
+      halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+  }
+
+  PremultiplyScalar(pixels + i * 4, count - i);
+}
+
+__attribute__((target("avx2")))
+static void PremultiplyAVX2(unsigned char* pixels, size_t count)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i round = _mm256_set1_epi16(128);
+  const __m256i alphaLanes = _mm256_setr_epi16(
+      0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+  const __m256i alphaOne = _mm256_setr_epi16(
+      0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i px = _mm256_loadu_si256((const __m256i*)(pixels + i * 4));
+
+    // unpack and pack both work per 128-bit lane, so the pixel order
+    // comes back out the same way it went in
+    __m256i halves[2] = { _mm256_unpacklo_epi8(px, zero), _mm256_unpackhi_epi8(px, zero) };
+    for (int h = 0; h < 2; h++)
+    {
+      __m256i a = _mm256_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, a), alphaOne);
+
+      __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(halves[h], a), round);
+      halves[h] = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    _mm256_storeu_si256((__m256i*)(pixels + i * 4), _mm256_packus_epi16(halves[0], halves[1]));
+  }
+
+  PremultiplySSE2(pixels + i * 4, count - i);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Optional decoders
+// ----------------------------------------------------------------------------
+
+#ifdef USE_LIBJPEG_TURBO
+struct JpegErrorManager
+{
+  jpeg_error_mgr base;
+  jmp_buf jump;
+};
+
+static void JpegErrorExit(j_common_ptr cinfo)
+{
+  longjmp(((JpegErrorManager*)cinfo->err)->jump, 1);
+}
+#endif
+
+static bool IsJpeg(const unsigned char* buffer, size_t length)
+{
+  return length > 3 && buffer[0] == 0xFF && buffer[1] == 0xD8 && buffer[2] == 0xFF;
+}
+
+static bool IsPng(const unsigned char* buffer, size_t length)
+{
+  return length > 8 && memcmp(buffer, "\x89PNG\r\n\x1a\n", 8) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// Image
+// ----------------------------------------------------------------------------
+
+Image::Image()
+{
+  data = nullptr;
+  width = 0;
+  height = 0;
+  channels = 0;
+  backend = IMAGE_BACKEND_AUTO;
+}
+
+bool Image::Load(const char* fileLoc, ImageBackend backend)
+{
+  FILE* file = fopen(fileLoc, "rb");
+  if (!file)
+  {
+    printf("Failed to find %s\n", fileLoc);
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  unsigned char* buffer = (unsigned char*)malloc(length > 0 ? length : 1);
+  size_t read = fread(buffer, 1, length, file);
+  fclose(file);
+
+  bool result = read == (size_t)length && LoadFromMemory(buffer, read, backend);
+  free(buffer);
+
+  if (!result)
+  {
+    printf("Failed to decode %s\n", fileLoc);
+  }
+
+  return result;
+}
+
+bool Image::LoadFromMemory(const unsigned char* buffer, size_t length, ImageBackend backend)
+{
+  ClearImage();
+
+  switch (backend)
+  {
+    case IMAGE_BACKEND_STB:
+      return DecodeStb(buffer, length);
+    case IMAGE_BACKEND_JPEG_TURBO:
+      return DecodeJpegTurbo(buffer, length);
+    case IMAGE_BACKEND_PNG:
+      return DecodePng(buffer, length);
+    default:
+      break;
+  }
+
+  // pick the fastest decoder we have for the format, and fall back to
+  // stb_image if it isn't compiled in or doesn't like the file
+  if (IsJpeg(buffer, length) && IsBackendAvailable(IMAGE_BACKEND_JPEG_TURBO) &&
+      DecodeJpegTurbo(buffer, length))
+  {
+    return true;
+  }
+
+  if (IsPng(buffer, length) && IsBackendAvailable(IMAGE_BACKEND_PNG) &&
+      DecodePng(buffer, length))
+  {
+    return true;
+  }
+
+  return DecodeStb(buffer, length);
+}
+
+bool Image::DecodeStb(const unsigned char* buffer, size_t length)
+{
+  data = stbi_load_from_memory(buffer, (int)length, &width, &height, &channels, 0);
+  if (!data)
+  {
+    return false;
+  }
+
+  backend = IMAGE_BACKEND_STB;
+  return true;
+}
+
+bool Image::DecodeJpegTurbo(const unsigned char* buffer, size_t length)
+{
+#ifdef USE_LIBJPEG_TURBO
+  if (!IsJpeg(buffer, length))
+  {
+    return false;
+  }
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager jerr;
+  cinfo.err = jpeg_std_error(&jerr.base);
+  jerr.base.error_exit = JpegErrorExit;
+
+  // written after setjmp, so it has to be volatile to survive the longjmp
+  unsigned char* volatile pixels = nullptr;
+
+  if (setjmp(jerr.jump))
+  {
+    jpeg_destroy_decompress(&cinfo);
+    free(pixels);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, buffer, length);
+  jpeg_read_header(&cinfo, TRUE);
+
+  // libjpeg-turbo can write rgba straight out of its SIMD color converter,
+  // which saves us from doing a separate expansion pass later on
+  int outChannels = 4;
+  if (cinfo.jpeg_color_space == JCS_GRAYSCALE)
+  {
+    cinfo.out_color_space = JCS_GRAYSCALE;
+    outChannels = 1;
+  }
+  else
+  {
+    cinfo.out_color_space = JCS_EXT_RGBA;
+  }
+
+  jpeg_start_decompress(&cinfo);
+
+  size_t rowSize = (size_t)cinfo.output_width * outChannels;
+  pixels = (unsigned char*)malloc(rowSize * cinfo.output_height);
+
+  while (cinfo.output_scanline < cinfo.output_height)
+  {
+    JSAMPROW row = pixels + rowSize * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+
+  width = cinfo.output_width;
+  height = cinfo.output_height;
+  channels = outChannels;
+
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  data = pixels;
+  backend = IMAGE_BACKEND_JPEG_TURBO;
+  return true;
+#else
+  (void)buffer;
+  (void)length;
+  return false;
+#endif
+}
+
+bool Image::DecodePng(const unsigned char* buffer, size_t length)
+{
+#ifdef USE_LIBPNG
+  if (!IsPng(buffer, length))
+  {
+    return false;
+  }
+
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+
+  if (!png_image_begin_read_from_memory(&image, buffer, length))
+  {
+    return false;
+  }
+
+  // keep the channel count of the file, but always ask for 8-bit samples
+  // and have palettes expanded
+  image.format &= PNG_FORMAT_FLAG_COLOR | PNG_FORMAT_FLAG_ALPHA;
+
+  unsigned char* pixels = (unsigned char*)malloc(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, nullptr, pixels, 0, nullptr))
+  {
+    png_image_free(&image);
+    free(pixels);
+    return false;
+  }
+
+  data = pixels;
+  width = image.width;
+  height = image.height;
+  channels = PNG_IMAGE_SAMPLE_CHANNELS(image.format);
+  backend = IMAGE_BACKEND_PNG;
+  return true;
+#else
+  (void)buffer;
+  (void)length;
+  return false;
+#endif
+}
+
+void Image::ExpandToRGBA()
+{
+  if (!data || channels == 4)
+  {
+    return;
+  }
+
+  size_t pixels = (size_t)width * height;
+  unsigned char* expanded = (unsigned char*)malloc(pixels * 4);
+
+  if (channels == 3)
+  {
+    ExpandRGB(data, expanded, pixels);
+  }
+  else
+  {
+    // grey and grey + alpha are rare enough that a plain loop will do
+    for (size_t i = 0; i < pixels; i++)
+    {
+      unsigned char grey = data[i * channels];
+      expanded[i * 4] = grey;
+      expanded[i * 4 + 1] = grey;
+      expanded[i * 4 + 2] = grey;
+      expanded[i * 4 + 3] = channels == 2 ? data[i * 2 + 1] : 255;
+    }
+  }
+
+  free(data);
+  data = expanded;
+  channels = 4;
+}
+
+void Image::FlipVertical()
+{
+  if (!data)
+  {
+    return;
+  }
+
+  size_t rowSize = (size_t)width * channels;
+  for (int y = 0; y < height / 2; y++)
+  {
+    SwapRows(data + rowSize * y, data + rowSize * (height - 1 - y), rowSize);
+  }
+}
+
+void Image::Premultiply()
+{
+  // only makes sense when there is an alpha channel to multiply by
+  if (!data || channels != 4)
+  {
+    return;
+  }
+
+  size_t pixels = (size_t)width * height;
+
+#ifdef IMAGE_SIMD_X86
+  if (__builtin_cpu_supports("avx2"))
+  {
+    PremultiplyAVX2(data, pixels);
+    return;
+  }
+
+  PremultiplySSE2(data, pixels);
+#else
+  PremultiplyScalar(data, pixels);
+#endif
+}
+
+bool Image::IsBackendAvailable(ImageBackend backend)
+{
+  switch (backend)
+  {
+    case IMAGE_BACKEND_AUTO:
+    case IMAGE_BACKEND_STB:
+      return true;
+#ifdef USE_LIBJPEG_TURBO
+    case IMAGE_BACKEND_JPEG_TURBO:
+      return true;
+#endif
+#ifdef USE_LIBPNG
+    case IMAGE_BACKEND_PNG:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* Image::GetBackendName(ImageBackend backend)
+{
+  switch (backend)
+  {
+    case IMAGE_BACKEND_AUTO: return "auto";
+    case IMAGE_BACKEND_STB: return "stb_image";
+    case IMAGE_BACKEND_JPEG_TURBO: return "libjpeg-turbo";
+    case IMAGE_BACKEND_PNG: return "libpng";
+    default: return "unknown";
+  }
+}
+
+void Image::ClearImage()
+{
+  // stb_image allocates with malloc as well, so free() works for every backend
+  free(data);
+  data = nullptr;
+  width = 0;
+  height = 0;
+  channels = 0;
+  backend = IMAGE_BACKEND_AUTO;
+}
+
+Image::~Image()
+{
+  ClearImage();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// image loading
+#include "stb_image.h"
+
+// The decoders an Image can be loaded with. stb_image is always compiled in
+// and is used as the fallback for anything the optional backends can't read.
+//
+// Optional backends are enabled at build time (see the makefile):
+//   USE_LIBJPEG_TURBO - SIMD jpeg decoding through libjpeg-turbo
+//   USE_LIBPNG        - png decoding through libpng (SSE2 row filters)
+enum ImageBackend
+{
+  IMAGE_BACKEND_AUTO = 0,
+  IMAGE_BACKEND_STB,
+  IMAGE_BACKEND_JPEG_TURBO,
+  IMAGE_BACKEND_PNG,
+  IMAGE_BACKEND_COUNT
+};
+
+class Image
+{
+  public:
+    Image();
+
+    bool Load(const char* fileLoc, ImageBackend backend = IMAGE_BACKEND_AUTO);
+    bool LoadFromMemory(const unsigned char* buffer, size_t length,
+        ImageBackend backend = IMAGE_BACKEND_AUTO);
+
+    // pixel format conversion, all done in place on the decoded data
+    void ExpandToRGBA();
+    void FlipVertical();
+    void Premultiply();
+
+    unsigned char* GetData() { return data; }
+    int GetWidth() { return width; }
+    int GetHeight() { return height; }
+    int GetChannels() { return channels; }
+    size_t GetSize() { return (size_t)width * height * channels; }
+    ImageBackend GetBackend() { return backend; }
+
+    static bool IsBackendAvailable(ImageBackend backend);
+    static const char* GetBackendName(ImageBackend backend);
+
+    void ClearImage();
+
+    ~Image();
+
+  private:
+    unsigned char* data;
+    int width, height, channels;
+    ImageBackend backend;
+
+    bool DecodeStb(const unsigned char* buffer, size_t length);
+    bool DecodeJpegTurbo(const unsigned char* buffer, size_t length);
+    bool DecodePng(const unsigned char* buffer, size_t length);
+
+    // Images own their pixels, so don't let them be copied around
+    Image(const Image&);
+    Image& operator=(const Image&);
+};
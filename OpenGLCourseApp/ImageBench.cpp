@@ -0,0 +1,183 @@
+// Decode throughput for every image in Textures/, once per available backend.
+// Build and run with `make bench` (add JPEG=1 PNG=1 for the optional backends).
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <stdio.h>
+#include <dirent.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+
+static const char* textureDir = "Textures/";
+static const int iterations = 5;
+
+struct ImageFile
+{
+  std::string name;
+  std::vector<unsigned char> contents;
+};
+
+std::vector<ImageFile> LoadFiles(const char* dirName)
+{
+  std::vector<ImageFile> files;
+
+  DIR* dir = opendir(dirName);
+  if (!dir)
+  {
+    printf("Failed to open %s\n", dirName);
+    return files;
+  }
+
+  while (dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name[0] == '.' || name[name.size() - 1] == '~')
+    {
+      continue;
+    }
+
+    FILE* file = fopen((std::string(dirName) + name).c_str(), "rb");
+    if (!file)
+    {
+      continue;
+    }
+
+    ImageFile imageFile;
+    imageFile.name = name;
+
+    unsigned char buffer[65536];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+      imageFile.contents.insert(imageFile.contents.end(), buffer, buffer + read);
+    }
+
+    fclose(file);
+    files.push_back(imageFile);
+  }
+
+  closedir(dir);
+  return files;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BenchBackend(std::vector<ImageFile>& files, ImageBackend backend)
+{
+  size_t decodedBytes = 0;
+  size_t fileCount = 0;
+  double seconds = 0.0;
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    Image image;
+
+    // skip anything this backend can't read (png files for libjpeg etc.)
+    if (!image.LoadFromMemory(&files[i].contents[0], files[i].contents.size(), backend))
+    {
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < iterations; j++)
+    {
+      image.LoadFromMemory(&files[i].contents[0], files[i].contents.size(), backend);
+    }
+    seconds += Seconds(start);
+
+    decodedBytes += image.GetSize() * iterations;
+    fileCount++;
+  }
+
+  if (fileCount == 0)
+  {
+    printf("%-16s no files\n", Image::GetBackendName(backend));
+    return;
+  }
+
+  printf("%-16s %3zu files  %8.1f MB/s\n",
+      Image::GetBackendName(backend),
+      fileCount,
+      decodedBytes / seconds / (1024.0 * 1024.0));
+}
+
+void BenchKernels(std::vector<ImageFile>& files)
+{
+  size_t expandBytes = 0, flipBytes = 0, premultiplyBytes = 0;
+  double expandTime = 0.0, flipTime = 0.0, premultiplyTime = 0.0;
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    Image image;
+    if (!image.LoadFromMemory(&files[i].contents[0], files[i].contents.size()))
+    {
+      continue;
+    }
+
+    for (int j = 0; j < iterations; j++)
+    {
+      // the expansion needs fresh rgb data every time round
+      if (image.GetChannels() != 3)
+      {
+        break;
+      }
+
+      Image copy;
+      copy.LoadFromMemory(&files[i].contents[0], files[i].contents.size());
+
+      auto start = std::chrono::steady_clock::now();
+      copy.ExpandToRGBA();
+      expandTime += Seconds(start);
+      expandBytes += copy.GetSize();
+    }
+
+    image.ExpandToRGBA();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < iterations; j++)
+    {
+      image.FlipVertical();
+    }
+    flipTime += Seconds(start);
+    flipBytes += image.GetSize() * iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int j = 0; j < iterations; j++)
+    {
+      image.Premultiply();
+    }
+    premultiplyTime += Seconds(start);
+    premultiplyBytes += image.GetSize() * iterations;
+  }
+
+  const double mb = 1024.0 * 1024.0;
+  printf("%-16s %8.1f MB/s\n", "rgb -> rgba", expandTime > 0.0 ? expandBytes / expandTime / mb : 0.0);
+  printf("%-16s %8.1f MB/s\n", "vertical flip", flipTime > 0.0 ? flipBytes / flipTime / mb : 0.0);
+  printf("%-16s %8.1f MB/s\n", "premultiply", premultiplyTime > 0.0 ? premultiplyBytes / premultiplyTime / mb : 0.0);
+}
+
+int main()
+{
+  std::vector<ImageFile> files = LoadFiles(textureDir);
+  printf("Loaded %zu files from %s\n\n", files.size(), textureDir);
+
+  printf("Decode (output bytes)\n");
+  for (int backend = IMAGE_BACKEND_STB; backend < IMAGE_BACKEND_COUNT; backend++)
+  {
+    if (Image::IsBackendAvailable((ImageBackend)backend))
+    {
+      BenchBackend(files, (ImageBackend)backend);
+    }
+  }
+
+  printf("\nConversion kernels (output bytes)\n");
+  BenchKernels(files);
+
+  return 0;
+}
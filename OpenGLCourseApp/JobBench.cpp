@@ -0,0 +1,180 @@
+// How the job system scales, on a made up scene of 100k moving objects.
+// Each frame moves everything, builds its matrix and bounds, then culls it
+// against a camera, the same steps main.cpp does for the real scene.
+// Build and run with `make jobbench`.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Frustum.h"
+#include "JobSystem.h"
+
+static const size_t entityCount = 100000;
+static const size_t batchSize = 1024;
+static const int frames = 100;
+
+struct Entity
+{
+  glm::vec3 position;
+  glm::vec3 velocity;
+  float angle;
+  float spin;
+  float radius;
+
+  glm::mat4 transform;
+  glm::vec3 boundsCenter;
+  float boundsRadius;
+  bool visible;
+};
+
+// a random scatter, the same every run so the timings compare
+std::vector<Entity> MakeScene()
+{
+  std::vector<Entity> entities(entityCount);
+  unsigned int seed = 1;
+
+  for (size_t i = 0; i < entities.size(); i++)
+  {
+    float random[7];
+    for (int j = 0; j < 7; j++)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      random[j] = (seed >> 8) / 16777216.0f;
+    }
+
+    Entity& entity = entities[i];
+    entity.position = glm::vec3(random[0], random[1], random[2]) * 400.0f - 200.0f;
+    entity.velocity = glm::vec3(random[3], random[4], random[5]) * 2.0f - 1.0f;
+    entity.angle = 0.0f;
+    entity.spin = random[6];
+    entity.radius = 0.5f + random[6];
+  }
+
+  return entities;
+}
+
+void UpdateEntities(std::vector<Entity>& entities, size_t begin, size_t end, float deltaTime)
+{
+  for (size_t i = begin; i < end; i++)
+  {
+    Entity& entity = entities[i];
+    entity.position += entity.velocity * deltaTime;
+    entity.angle += entity.spin * deltaTime;
+
+    glm::mat4 model(1.0f);
+    model = glm::translate(model, entity.position);
+    model = glm::rotate(model, entity.angle, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(entity.radius));
+    entity.transform = model;
+
+    entity.boundsCenter = glm::vec3(model * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    entity.boundsRadius = entity.radius * 1.7320508f;
+  }
+}
+
+void CullEntities(std::vector<Entity>& entities, size_t begin, size_t end, const Frustum& frustum)
+{
+  for (size_t i = begin; i < end; i++)
+  {
+    Entity& entity = entities[i];
+    entity.visible = frustum.IntersectsSphere(entity.boundsCenter, entity.boundsRadius);
+  }
+}
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// milliseconds a frame with this many threads
+double BenchThreads(size_t threadCount, size_t& visibleCount)
+{
+  JobSystem::Init(threadCount);
+  std::vector<Entity> entities = MakeScene();
+
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 300.0f);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; frame++)
+  {
+    float deltaTime = 1.0f / 60.0f;
+
+    // the camera turns a little each frame, like the real one would
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f),
+        glm::vec3(sinf(frame * 0.01f), 0.0f, -cosf(frame * 0.01f)),
+        glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    // culling needs the new bounds, so it waits on the update
+    Job* update = JobSystem::Create([&entities, deltaTime]()
+    {
+      JobSystem::ParallelFor(entities.size(), batchSize, [&entities, deltaTime](size_t begin, size_t end)
+      {
+        UpdateEntities(entities, begin, end, deltaTime);
+      });
+    });
+    Job* cull = JobSystem::Create([&entities, &frustum]()
+    {
+      JobSystem::ParallelFor(entities.size(), batchSize, [&entities, &frustum](size_t begin, size_t end)
+      {
+        CullEntities(entities, begin, end, frustum);
+      });
+    });
+    JobSystem::AddDependency(cull, update);
+
+    JobSystem::Run(cull);
+    JobSystem::Run(update);
+    JobSystem::Wait(cull);
+    JobSystem::EndFrame();
+  }
+  double seconds = Seconds(start);
+
+  visibleCount = 0;
+  for (size_t i = 0; i < entities.size(); i++)
+  {
+    visibleCount += entities[i].visible ? 1 : 0;
+  }
+
+  JobSystem::Shutdown();
+  return seconds * 1000.0 / frames;
+}
+
+// the thread counts go up in powers of two to the number of cores, or to
+// the first argument when there is one
+int main(int argc, char** argv)
+{
+  size_t maxThreads = argc > 1 ? strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+  if (maxThreads == 0)
+  {
+    maxThreads = 1;
+  }
+
+  printf("%zu entities, %d frames, batches of %zu\n\n", entityCount, frames, batchSize);
+  printf("threads   ms/frame   speedup   visible\n");
+
+  double single = 0.0;
+  for (size_t threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads)
+  {
+    size_t visibleCount = 0;
+    double ms = BenchThreads(threads, visibleCount);
+    if (threads == 1)
+    {
+      single = ms;
+    }
+
+    printf("%7zu %10.3f %8.2fx %9zu\n", threads, ms, single / ms, visibleCount);
+
+    if (threads == maxThreads)
+    {
+      break;
+    }
+  }
+
+  return 0;
+}
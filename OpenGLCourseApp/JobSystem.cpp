@@ -0,0 +1,305 @@
+#include "JobSystem.h"
+
+#include <stdio.h>
+
+std::vector<JobSystem::Queue*> JobSystem::queues;
+std::vector<std::thread> JobSystem::workers;
+std::atomic<bool> JobSystem::quitting(false);
+
+size_t JobSystem::firstAppQueue = 0;
+std::atomic<size_t> JobSystem::nextAppQueue(0);
+
+std::mutex JobSystem::sleepMutex;
+std::condition_variable JobSystem::wake;
+std::atomic<int> JobSystem::queuedCount(0);
+
+// which queue is this thread's. 0 for the thread that called Init, and any
+// other thread that isn't a worker and hasn't registered.
+static thread_local size_t threadIndex = 0;
+
+// Jobs made outside of any job go in the pool of the thread that made
+// them, jobs made inside one go in that job's pool. So each thread that
+// starts a graph gets the whole graph back in its own pool, and its
+// EndFrame can't free anyone else's.
+static thread_local JobPool ownPool;
+static thread_local JobPool* currentPool = nullptr;
+
+void JobSystem::Init(size_t threadCount, size_t appThreads)
+{
+  Shutdown();
+
+  if (threadCount == 0)
+  {
+    threadCount = std::thread::hardware_concurrency();
+  }
+  if (threadCount == 0)
+  {
+    threadCount = 1;
+  }
+
+  // all made up front, the list never changes while the workers run
+  for (size_t i = 0; i < threadCount + appThreads; i++)
+  {
+    queues.push_back(new Queue());
+  }
+
+  firstAppQueue = threadCount;
+  nextAppQueue = threadCount;
+
+  quitting = false;
+  for (size_t i = 1; i < threadCount; i++)
+  {
+    workers.push_back(std::thread(WorkerLoop, i));
+  }
+}
+
+void JobSystem::Shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    quitting = true;
+  }
+  wake.notify_all();
+
+  for (size_t i = 0; i < workers.size(); i++)
+  {
+    workers[i].join();
+  }
+  workers.clear();
+
+  for (size_t i = 0; i < queues.size(); i++)
+  {
+    delete queues[i];
+  }
+  queues.clear();
+
+  queuedCount = 0;
+  firstAppQueue = 0;
+  nextAppQueue = 0;
+  EndFrame();
+}
+
+bool JobSystem::RegisterThread()
+{
+  size_t index = nextAppQueue++;
+  if (index >= queues.size())
+  {
+    printf("No job queue left for another thread, it'll share the main one\n");
+    return false;
+  }
+
+  threadIndex = index;
+  return true;
+}
+
+Job* JobSystem::Create(std::function<void()> work)
+{
+  JobPool* pool = currentPool ? currentPool : &ownPool;
+  std::lock_guard<std::mutex> lock(pool->mutex);
+
+  pool->jobs.emplace_back();
+  Job* job = &pool->jobs.back();
+  job->work = work;
+  job->pool = pool;
+  job->pending = 1;
+  job->done = false;
+
+  return job;
+}
+
+void JobSystem::AddDependency(Job* after, Job* before)
+{
+  before->dependents.push_back(after);
+  after->pending++;
+}
+
+void JobSystem::Run(Job* job)
+{
+  // whoever takes pending to 0 pushes it, this or the last dependency
+  if (--job->pending == 0)
+  {
+    Push(job);
+  }
+}
+
+Job* JobSystem::Schedule(std::function<void()> work)
+{
+  Job* job = Create(work);
+  Run(job);
+  return job;
+}
+
+void JobSystem::Wait(Job* job)
+{
+  while (!job->done)
+  {
+    Job* other = FindJob();
+    if (other)
+    {
+      Execute(other);
+    }
+    else
+    {
+      // whatever it's waiting on is running somewhere else
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize,
+    const std::function<void(size_t, size_t)>& body)
+{
+  if (batchSize == 0)
+  {
+    batchSize = 1;
+  }
+
+  // not worth a job
+  if (count <= batchSize || workers.empty())
+  {
+    body(0, count);
+    return;
+  }
+
+  // does nothing, it's just there to be waited on
+  Job* all = Create([]() {});
+
+  std::vector<Job*> batches;
+  for (size_t begin = 0; begin < count; begin += batchSize)
+  {
+    size_t end = begin + batchSize < count ? begin + batchSize : count;
+
+    Job* batch = Create([&body, begin, end]() { body(begin, end); });
+    AddDependency(all, batch);
+    batches.push_back(batch);
+  }
+
+  Run(all);
+  for (size_t i = 0; i < batches.size(); i++)
+  {
+    Run(batches[i]);
+  }
+
+  Wait(all);
+}
+
+void JobSystem::EndFrame()
+{
+  std::lock_guard<std::mutex> lock(ownPool.mutex);
+  ownPool.jobs.clear();
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+  threadIndex = index;
+
+  while (!quitting)
+  {
+    Job* job = FindJob();
+    if (job)
+    {
+      Execute(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, []() { return queuedCount > 0 || quitting; });
+  }
+}
+
+void JobSystem::Push(Job* job)
+{
+  // no threads at all, nobody else is ever going to run it
+  if (queues.empty())
+  {
+    Execute(job);
+    return;
+  }
+
+  Queue* queue = queues[threadIndex];
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->jobs.push_back(job);
+  }
+
+  // counted under the sleep lock, so a worker can't check the count and
+  // then miss the wake up
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    queuedCount++;
+  }
+  wake.notify_one();
+}
+
+Job* JobSystem::FindJob()
+{
+  if (queues.empty())
+  {
+    return nullptr;
+  }
+
+  // the newest job on our own queue first
+  Queue* own = queues[threadIndex];
+  {
+    std::lock_guard<std::mutex> lock(own->mutex);
+    if (!own->jobs.empty())
+    {
+      Job* job = own->jobs.back();
+      own->jobs.pop_back();
+      queuedCount--;
+      return job;
+    }
+  }
+
+  // then the oldest from everyone else, starting with our neighbour so
+  // the threads don't all pile on the same queue. The app's own threads
+  // leave each other's queues alone, so one of them waiting on its graph
+  // doesn't end up running the other's.
+  bool isWorker = IsWorkerQueue(threadIndex);
+  for (size_t i = 1; i < queues.size(); i++)
+  {
+    size_t victimIndex = (threadIndex + i) % queues.size();
+    if (!isWorker && !IsWorkerQueue(victimIndex))
+    {
+      continue;
+    }
+
+    Queue* victim = queues[victimIndex];
+
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->jobs.empty())
+    {
+      Job* job = victim->jobs.front();
+      victim->jobs.pop_front();
+      queuedCount--;
+      return job;
+    }
+  }
+
+  return nullptr;
+}
+
+bool JobSystem::IsWorkerQueue(size_t index)
+{
+  return index > 0 && index < firstAppQueue;
+}
+
+void JobSystem::Execute(Job* job)
+{
+  JobPool* previousPool = currentPool;
+  currentPool = job->pool;
+  job->work();
+  currentPool = previousPool;
+
+  // Once it's done, whoever is waiting on it may free it, so nothing of
+  // the job itself can be touched after. The dependents can't go anywhere
+  // until they've been run.
+  std::vector<Job*> dependents;
+  dependents.swap(job->dependents);
+  job->done = true;
+
+  for (size_t i = 0; i < dependents.size(); i++)
+  {
+    Run(dependents[i]);
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobPool;
+
+// One piece of work, and the jobs that can't start until it's done.
+// Made with JobSystem::Create, nothing else should touch the members.
+struct Job
+{
+  std::function<void()> work;
+  std::vector<Job*> dependents;
+  JobPool* pool;
+
+  // dependencies still running, plus one until it's Run
+  std::atomic<int> pending;
+  std::atomic<bool> done;
+};
+
+// where jobs are kept until EndFrame
+struct JobPool
+{
+  std::mutex mutex;
+  std::deque<Job> jobs;
+};
+
+// A fixed set of worker threads that run jobs for the rest of the app.
+//
+// Every thread has a deque of its own. New jobs go on the back of the one
+// for the thread that made them ready, which takes from the back as well,
+// so it's mostly working on what it just touched. A thread that runs out
+// steals from the front of someone else's.
+//
+// Dependencies are continuations: a job lists the jobs waiting on it, and
+// the one that finishes last pushes them. Nothing ever blocks on a job
+// except Wait, which runs other jobs in the meantime.
+//
+// Jobs live until EndFrame, so a Job* is good for the rest of the frame.
+// More than one thread can be running a graph at once, each one only
+// frees its own.
+class JobSystem
+{
+  public:
+    // threadCount counts the calling thread, which only runs jobs inside
+    // Wait. 0 for one per core. appThreads more queues are kept for other
+    // threads of the app's own to take with RegisterThread. Can be called
+    // again to change the counts.
+    static void Init(size_t threadCount = 0, size_t appThreads = 0);
+    static void Shutdown();
+
+    // Gives the calling thread a queue of its own, for a thread that isn't
+    // a worker but runs graphs of its own. Until then it shares the one
+    // the Init thread uses. False if there are none left.
+    static bool RegisterThread();
+
+    static size_t GetThreadCount() { return queues.size(); }
+
+    // made but not started, so dependencies can be added first
+    static Job* Create(std::function<void()> work);
+
+    // after won't start until before is done. Has to be called before
+    // either of them is Run.
+    static void AddDependency(Job* after, Job* before);
+
+    // queued as soon as everything it depends on is done
+    static void Run(Job* job);
+
+    // Create and Run in one, for a job nothing depends on
+    static Job* Schedule(std::function<void()> work);
+
+    // runs other jobs until this one is done. Fine to call from inside a
+    // job, that thread just keeps working.
+    static void Wait(Job* job);
+
+    // body(begin, end) for every batch of batchSize in 0 to count, spread
+    // over all the threads. Returns once they're all done.
+    static void ParallelFor(size_t count, size_t batchSize,
+        const std::function<void(size_t, size_t)>& body);
+
+    // frees every job this thread made since the last call, and every job
+    // those made. None of them can still be running.
+    static void EndFrame();
+
+  private:
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Job*> jobs;
+    };
+
+    static std::vector<Queue*> queues;
+    static std::vector<std::thread> workers;
+    static std::atomic<bool> quitting;
+
+    // queues[0] is the Init thread's, then one for each worker, then the
+    // ones RegisterThread hands out
+    static size_t firstAppQueue;
+    static std::atomic<size_t> nextAppQueue;
+
+    // workers with nothing to steal sleep here until a job is pushed
+    static std::mutex sleepMutex;
+    static std::condition_variable wake;
+    static std::atomic<int> queuedCount;
+
+    static void WorkerLoop(size_t index);
+    static void Push(Job* job);
+    static bool IsWorkerQueue(size_t index);
+    static Job* FindJob();
+    static void Execute(Job* job);
+};
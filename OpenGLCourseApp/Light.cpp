@@ -7,14 +7,16 @@ Light::Light()
   color = glm::vec3(1.0f, 1.0f, 1.0f);
   ambientIntensity = 1.0f;
   diffuseIntensity = 0.0f;
+
+  shadowMap = nullptr;
 }
 
-Light::Light(GLfloat shadowWidth, GLfloat shadowHeight,
-    GLfloat red, GLfloat green, GLfloat blue,
+Light::Light(GLfloat red, GLfloat green, GLfloat blue,
     GLfloat aIntensity, GLfloat dIntensity)
 {
-  shadowMap = new ShadowMap();
-  shadowMap->Init(shadowWidth, shadowHeight);
+  // only the directional light has a shadow map of its own, point and
+  // spot lights draw into the shadow atlas
+  shadowMap = nullptr;
 
   color = glm::vec3(red, green, blue);
   ambientIntensity = aIntensity;
@@ -11,8 +11,7 @@ class Light
   public:
     Light();
 
-    Light(GLfloat shadowWidth, GLfloat shadowHeight,
-        GLfloat red, GLfloat green, GLfloat blue,
+    Light(GLfloat red, GLfloat green, GLfloat blue,
         GLfloat aIntensity, GLfloat dIntensity);
 
     ShadowMap* GetShadowMap() { return shadowMap; }
@@ -1,21 +1,42 @@
 #include "Material.h"
 
+#include "UniformState.h"
+
 Material::Material()
 {
   specularIntensity = 0.0f;
   shininess = 0.0f;
+  samplerState = Sampler::DefaultState();
+  sampler = nullptr;
 }
 
 Material::Material(GLfloat sIntensity, GLfloat shine)
 {
   specularIntensity = sIntensity;
   shininess = shine;
+  samplerState = Sampler::DefaultState();
+  sampler = nullptr;
+}
+
+Material::Material(GLfloat sIntensity, GLfloat shine, const SamplerState& sState)
+{
+  specularIntensity = sIntensity;
+  shininess = shine;
+  samplerState = sState;
+  sampler = nullptr;
 }
 
 void Material::UseMaterial(GLuint specularIntensityLocation, GLuint shininessLocation)
 {
-  glUniform1f(specularIntensityLocation, specularIntensity);
-  glUniform1f(shininessLocation, shininess);
+  UniformState::Set1f(specularIntensityLocation, specularIntensity);
+  UniformState::Set1f(shininessLocation, shininess);
+
+  if (!sampler)
+  {
+    sampler = Sampler::Get(samplerState);
+  }
+
+  sampler->Use(DIFFUSE_TEXTURE_UNIT);
 }
 
 Material::~Material(){}
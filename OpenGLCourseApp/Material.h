@@ -2,20 +2,32 @@
 
 #include <GL/glew.h>
 
+#include "CommonValues.h"
+#include "Sampler.h"
+
 class Material
 {
   public:
     Material();
     Material(GLfloat sIntensity, GLfloat shine);
+    Material(GLfloat sIntensity, GLfloat shine, const SamplerState& sState);
     
     void UseMaterial(GLuint specularIntensityLocation, GLuint shininessLocation);
 
+    GLfloat GetSpecularIntensity() { return specularIntensity; }
+    GLfloat GetShininess() { return shininess; }
+
     ~Material();
 
   private:
     // dictates how much specular light should be on the object
     GLfloat specularIntensity;
     // how smooth the surface is going to be portrayed as (roughness)
-    GLfloat shininess;;
-};
+    GLfloat shininess;
 
+    // how the diffuse texture should be filtered. The sampler object itself
+    // is shared and only looked up the first time the material gets used,
+    // since materials can be made before there is an OpenGL context.
+    SamplerState samplerState;
+    Sampler* sampler;
+};
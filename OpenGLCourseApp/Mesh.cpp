@@ -6,6 +6,8 @@ Mesh::Mesh()
   VBO = 0;
   IBO = 0;
   indexCount = 0;
+  boundsMin = glm::vec3(0.0f);
+  boundsMax = glm::vec3(0.0f);
 }
 
 void Mesh::CreateMesh(GLfloat *vertices,
@@ -15,6 +17,19 @@ void Mesh::CreateMesh(GLfloat *vertices,
 {
   indexCount = numOfIndices; 
 
+  // positions are the first 3 of every 8 floats
+  if (numOfVertices >= 8)
+  {
+    boundsMin = boundsMax = glm::vec3(vertices[0], vertices[1], vertices[2]);
+  }
+
+  for (unsigned int i = 8; i + 2 < numOfVertices; i += 8)
+  {
+    glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+    boundsMin = glm::min(boundsMin, position);
+    boundsMax = glm::max(boundsMax, position);
+  }
+
   // adds one vertex array to the VRAM and obtain the ID for it
   glGenVertexArrays(1, &VAO);
   glBindVertexArray(VAO);
@@ -1,5 +1,7 @@
 #include <GL/glew.h>
 
+#include <glm/glm.hpp>
+
 #pragma once
 class Mesh
 {
@@ -13,9 +15,15 @@ class Mesh
     void RenderMesh();
     void ClearMesh();
 
+    // the box around every vertex, in the mesh's own space
+    glm::vec3 GetBoundsMin() { return boundsMin; }
+    glm::vec3 GetBoundsMax() { return boundsMax; }
+
     ~Mesh();
 
   private:
     GLuint VAO, VBO, IBO;
     GLsizei indexCount;
+
+    glm::vec3 boundsMin, boundsMax;
 };
@@ -0,0 +1,306 @@
+#include "MipChain.h"
+
+#include <math.h>
+#include <string.h>
+
+// each pixel is four floats, which lines up perfectly with one SSE register
+#if defined(__SSE2__)
+#define MIP_CHAIN_SIMD
+#include <emmintrin.h>
+#endif
+
+// fine enough that going linear -> sRGB is off by at most a quarter of a step
+static const int linearTableSize = 16384;
+
+struct GammaTables
+{
+  float toLinear[256];
+  unsigned char toSrgb[linearTableSize];
+
+  GammaTables()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      float c = i / 255.0f;
+      toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (int i = 0; i < linearTableSize; i++)
+    {
+      float l = i / (float)(linearTableSize - 1);
+      float s = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+      toSrgb[i] = (unsigned char)(s * 255.0f + 0.5f);
+    }
+  }
+};
+
+// The kaiser filter is a windowed sinc with 8 taps in the source image,
+// centered between the two source pixels that make up each output pixel.
+static const int kaiserTaps = 8;
+
+struct KaiserKernel
+{
+  float weights[kaiserTaps];
+
+  KaiserKernel()
+  {
+    const float pi = 3.14159265f;
+    const float beta = 4.0f;
+    const float radius = 2.0f; // in destination pixels
+
+    float sum = 0.0f;
+    for (int t = 0; t < kaiserTaps; t++)
+    {
+      // distance from the center, measured in destination pixels
+      float d = ((t - kaiserTaps / 2 + 1) - 0.5f) * 0.5f;
+      float sinc = d == 0.0f ? 1.0f : sinf(pi * d) / (pi * d);
+
+      float x = d / radius;
+      float window = BesselI0(beta * sqrtf(1.0f - x * x)) / BesselI0(beta);
+
+      weights[t] = sinc * window;
+      sum += weights[t];
+    }
+
+    for (int t = 0; t < kaiserTaps; t++)
+    {
+      weights[t] /= sum;
+    }
+  }
+
+  static float BesselI0(float x)
+  {
+    // the series converges quickly for the small values we feed it
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 16; k++)
+    {
+      term *= (x * 0.5f / k) * (x * 0.5f / k);
+      sum += term;
+    }
+
+    return sum;
+  }
+};
+
+static const GammaTables& GetGammaTables()
+{
+  static GammaTables tables;
+  return tables;
+}
+
+static const KaiserKernel& GetKaiserKernel()
+{
+  static KaiserKernel kernel;
+  return kernel;
+}
+
+static void ToLinear(const unsigned char* src, float* dst, size_t pixels)
+{
+  const GammaTables& tables = GetGammaTables();
+
+  for (size_t i = 0; i < pixels; i++)
+  {
+    dst[i * 4] = tables.toLinear[src[i * 4]];
+    dst[i * 4 + 1] = tables.toLinear[src[i * 4 + 1]];
+    dst[i * 4 + 2] = tables.toLinear[src[i * 4 + 2]];
+    dst[i * 4 + 3] = src[i * 4 + 3] / 255.0f;
+  }
+}
+
+static void ToSrgb(const float* src, unsigned char* dst, size_t pixels)
+{
+  const GammaTables& tables = GetGammaTables();
+
+#ifdef MIP_CHAIN_SIMD
+  // color goes through the lookup table, alpha is just scaled back to a byte
+  const __m128 scale = _mm_setr_ps(
+      linearTableSize - 1, linearTableSize - 1, linearTableSize - 1, 255.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (size_t i = 0; i < pixels; i++)
+  {
+    // the kaiser filter can ring slightly outside of 0 to 1, so clamp first
+    __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i * 4), zero), one);
+
+    int index[4];
+    _mm_storeu_si128((__m128i*)index, _mm_cvtps_epi32(_mm_mul_ps(v, scale)));
+
+    dst[i * 4] = tables.toSrgb[index[0]];
+    dst[i * 4 + 1] = tables.toSrgb[index[1]];
+    dst[i * 4 + 2] = tables.toSrgb[index[2]];
+    dst[i * 4 + 3] = (unsigned char)index[3];
+  }
+#else
+  for (size_t i = 0; i < pixels; i++)
+  {
+    for (int c = 0; c < 4; c++)
+    {
+      float v = fminf(fmaxf(src[i * 4 + c], 0.0f), 1.0f);
+      dst[i * 4 + c] = c < 3 ?
+        tables.toSrgb[(int)(v * (linearTableSize - 1) + 0.5f)] :
+        (unsigned char)(v * 255.0f + 0.5f);
+    }
+  }
+#endif
+}
+
+static void DownsampleBox(const float* src, int width, int height,
+    float* dst, int newWidth, int newHeight)
+{
+  for (int y = 0; y < newHeight; y++)
+  {
+    // clamping takes care of levels that are only 1 pixel tall or wide
+    const float* row0 = src + (size_t)(2 * y) * width * 4;
+    const float* row1 = src + (size_t)(2 * y + 1 < height ? 2 * y + 1 : height - 1) * width * 4;
+
+    for (int x = 0; x < newWidth; x++)
+    {
+      int x0 = 2 * x * 4;
+      int x1 = (2 * x + 1 < width ? 2 * x + 1 : width - 1) * 4;
+      float* out = dst + ((size_t)y * newWidth + x) * 4;
+
+#ifdef MIP_CHAIN_SIMD
+      __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1));
+      __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1));
+      _mm_storeu_ps(out, _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+#else
+      for (int c = 0; c < 4; c++)
+      {
+        out[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+      }
+#endif
+    }
+  }
+}
+
+// Filters one axis down by half. The stride arguments let the same loop do
+// both the horizontal and the vertical pass.
+static void KaiserPass(const float* src, float* dst,
+    int srcLength, int dstLength, int lines,
+    size_t srcStride, size_t dstStride,
+    size_t srcLineStride, size_t dstLineStride)
+{
+  const KaiserKernel& kernel = GetKaiserKernel();
+
+  for (int line = 0; line < lines; line++)
+  {
+    const float* in = src + line * srcLineStride;
+    float* out = dst + line * dstLineStride;
+
+    for (int i = 0; i < dstLength; i++)
+    {
+#ifdef MIP_CHAIN_SIMD
+      __m128 sum = _mm_setzero_ps();
+#else
+      float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+#endif
+
+      for (int t = 0; t < kaiserTaps; t++)
+      {
+        int s = 2 * i + t - kaiserTaps / 2 + 1;
+        s = s < 0 ? 0 : (s >= srcLength ? srcLength - 1 : s);
+
+#ifdef MIP_CHAIN_SIMD
+        sum = _mm_add_ps(sum,
+            _mm_mul_ps(_mm_loadu_ps(in + s * srcStride), _mm_set1_ps(kernel.weights[t])));
+#else
+        for (int c = 0; c < 4; c++)
+        {
+          sum[c] += in[s * srcStride + c] * kernel.weights[t];
+        }
+#endif
+      }
+
+#ifdef MIP_CHAIN_SIMD
+      _mm_storeu_ps(out + i * dstStride, sum);
+#else
+      memcpy(out + i * dstStride, sum, sizeof(sum));
+#endif
+    }
+  }
+}
+
+static void DownsampleKaiser(const float* src, int width, int height,
+    float* dst, int newWidth, int newHeight)
+{
+  // horizontal first into a (newWidth x height) image, then vertical
+  std::vector<float> temp((size_t)newWidth * height * 4);
+
+  KaiserPass(src, &temp[0], width, newWidth, height,
+      4, 4, (size_t)width * 4, (size_t)newWidth * 4);
+
+  KaiserPass(&temp[0], dst, height, newHeight, newWidth,
+      (size_t)newWidth * 4, (size_t)newWidth * 4, 4, 4);
+}
+
+MipChain::MipChain(){}
+
+void MipChain::Generate(const unsigned char* rgba, int width, int height, MipFilter filter)
+{
+  ClearMipChain();
+
+  if (!rgba || width <= 0 || height <= 0)
+  {
+    return;
+  }
+
+  // work out how much space the whole chain needs up front
+  size_t totalSize = 0;
+  for (int w = width, h = height; ; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1)
+  {
+    totalSize += (size_t)w * h * 4;
+    if (w == 1 && h == 1)
+    {
+      break;
+    }
+  }
+
+  pixels.resize(totalSize);
+
+  // the base level is just the original image
+  Level base = { width, height, 0 };
+  levels.push_back(base);
+  memcpy(&pixels[0], rgba, (size_t)width * height * 4);
+
+  std::vector<float> current((size_t)width * height * 4);
+  std::vector<float> next;
+  ToLinear(rgba, &current[0], (size_t)width * height);
+
+  int w = width, h = height;
+  size_t offset = (size_t)width * height * 4;
+
+  while (w > 1 || h > 1)
+  {
+    int newWidth = w > 1 ? w / 2 : 1;
+    int newHeight = h > 1 ? h / 2 : 1;
+    next.resize((size_t)newWidth * newHeight * 4);
+
+    if (filter == MIP_FILTER_KAISER)
+    {
+      DownsampleKaiser(&current[0], w, h, &next[0], newWidth, newHeight);
+    }
+    else
+    {
+      DownsampleBox(&current[0], w, h, &next[0], newWidth, newHeight);
+    }
+
+    Level level = { newWidth, newHeight, offset };
+    levels.push_back(level);
+    ToSrgb(&next[0], &pixels[offset], (size_t)newWidth * newHeight);
+
+    offset += (size_t)newWidth * newHeight * 4;
+    current.swap(next);
+    w = newWidth;
+    h = newHeight;
+  }
+}
+
+void MipChain::ClearMipChain()
+{
+  levels.clear();
+  pixels.clear();
+  pixels.shrink_to_fit();
+}
+
+MipChain::~MipChain(){}
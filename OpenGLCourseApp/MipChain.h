@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// How each level is made from the one above it.
+//   MIP_FILTER_BOX    - plain 2x2 average, cheap and good enough for most things
+//   MIP_FILTER_KAISER - 8-tap kaiser windowed sinc, keeps fine detail sharper
+enum MipFilter
+{
+  MIP_FILTER_BOX = 0,
+  MIP_FILTER_KAISER
+};
+
+// Builds a full mip chain for an sRGB rgba8 image on the CPU.
+//
+// Filtering is done on linear floats so the smaller levels don't darken the
+// way a straight average of sRGB bytes does. Alpha is treated as linear.
+// Nothing in here touches OpenGL, so it is safe to run on a worker thread.
+class MipChain
+{
+  public:
+    MipChain();
+
+    void Generate(const unsigned char* rgba, int width, int height,
+        MipFilter filter = MIP_FILTER_BOX);
+
+    int GetLevelCount() { return (int)levels.size(); }
+    int GetLevelWidth(int level) { return levels[level].width; }
+    int GetLevelHeight(int level) { return levels[level].height; }
+    const unsigned char* GetLevelData(int level) { return &pixels[levels[level].offset]; }
+
+    void ClearMipChain();
+
+    ~MipChain();
+
+  private:
+    struct Level
+    {
+      int width, height;
+      size_t offset;
+    };
+
+    std::vector<Level> levels;
+    // every level packed one after the other as sRGB rgba8
+    std::vector<unsigned char> pixels;
+};
@@ -1,10 +1,22 @@
 #include "Model.h"
 
-Model::Model(){}
+#include "AssetIOSystem.h"
+#include "TextureTable.h"
+
+Model::Model()
+{
+  boundsMin = glm::vec3(0.0f);
+  boundsMax = glm::vec3(0.0f);
+}
 
 void Model::LoadModel(const std::string& fileName)
 {
   Assimp::Importer importer;
+
+  // read the model (and anything it references) through the asset pack.
+  // The importer owns the io system and deletes it when it's done.
+  importer.SetIOHandler(new AssetIOSystem());
+
   const aiScene* scene = importer.ReadFile(
       fileName,
       aiProcess_Triangulate | 
@@ -20,15 +32,24 @@ void Model::LoadModel(const std::string& fileName)
 
   LoadNode(scene->mRootNode, scene);
   LoadMaterials(scene);
+
+  for (size_t i = 0; i < meshList.size(); i++)
+  {
+    glm::vec3 meshMin = meshList[i]->GetBoundsMin();
+    glm::vec3 meshMax = meshList[i]->GetBoundsMax();
+
+    boundsMin = i == 0 ? meshMin : glm::min(boundsMin, meshMin);
+    boundsMax = i == 0 ? meshMax : glm::max(boundsMax, meshMax);
+  }
 }
 
-void Model::RenderModel()
+void Model::RenderModel(bool bindTextures)
 {
   for (size_t i = 0; i < meshList.size(); i++)
   {
     unsigned int materialIndex = meshToTex[i];
 
-    if (materialIndex < textureList.size() && textureList[materialIndex])
+    if (bindTextures && materialIndex < textureList.size() && textureList[materialIndex])
     {
       textureList[materialIndex]->UseTexture();
     }
@@ -143,16 +164,22 @@ void Model::LoadMaterials(const aiScene* scene)
         std::string texPath = std::string("Textures/") + filename;
 
         textureList[i] = new Texture(texPath.c_str());
-
-        // assuming there are no alpha channels
-        if (!textureList[i]->LoadTexture())
-        {
-          printf("Failed to load texture at: %s\n", texPath);
-          delete textureList[i];
-          textureList[i] = nullptr;
-        }
       }
     }
+  }
+
+  // decode all of the textures in parallel before touching OpenGL
+  Texture::DecodeAll(textureList);
+
+  for (size_t i = 0; i < textureList.size(); i++)
+  {
+    // assuming there are no alpha channels
+    if (textureList[i] && !textureList[i]->LoadTexture())
+    {
+      printf("Failed to load texture at: %s\n", textureList[i]->GetFileLocation());
+      delete textureList[i];
+      textureList[i] = nullptr;
+    }
 
     // if failed to load in a texture, or if there just wasn't one to begin with,
     // we'll use a default texture
@@ -161,6 +188,8 @@ void Model::LoadMaterials(const aiScene* scene)
       textureList[i] = new Texture("Textures/plain.png");
       textureList[i]->LoadTextureA();
     }
+
+    TextureTable::Add(textureList[i]);
   }
 }
 
@@ -16,9 +16,14 @@ class Model
     Model();
 
     void LoadModel(const std::string& fileName);
-    void RenderModel();
+    // shadow and depth passes have no use for the textures
+    void RenderModel(bool bindTextures = true);
     void ClearModel();
 
+    // around every mesh in the model, in the model's own space
+    glm::vec3 GetBoundsMin() { return boundsMin; }
+    glm::vec3 GetBoundsMax() { return boundsMax; }
+
     ~Model();
 
   private:
@@ -29,4 +34,6 @@ class Model
     std::vector<Mesh*> meshList;
     std::vector<Texture*> textureList;
     std::vector<unsigned int> meshToTex;
+
+    glm::vec3 boundsMin, boundsMax;
 };
@@ -1,68 +0,0 @@
-#include "OmniShadowMap.h"
-
-OmniShadowMap::OmniShadowMap() : ShadowMap(){}
-
-bool OmniShadowMap::Init(GLuint width, GLuint height)
-{
-  shadowWidth = width;
-  shadowHeight = height;
-
-  glGenFramebuffers(1, &FBO);
-
-  glGenTextures(1, &shadowMap);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMap);
-
-  // prepare each side of our cubemap
-  for (size_t i = 0; i < 6; i++)
-  {
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-        0,
-        GL_DEPTH_COMPONENT,
-        shadowWidth,
-        shadowHeight,
-        0,
-        GL_DEPTH_COMPONENT,
-        GL_FLOAT,
-        nullptr); // remember, the framebuffer will supply this data so use nullptr
-  }
-
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  // remember, we are in 3 dimensions so we also have R
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-  glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-  // Since we're working with a cube map, do the following instead of texture2D
-  glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0);
-
-  glDrawBuffer(GL_NONE);
-  glReadBuffer(GL_NONE);
-
-  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-  if (status != GL_FRAMEBUFFER_COMPLETE)
-  {
-    printf("Framebuffer Error: %i\n", status);
-    return false;
-  }
-
-  // unbind framebuffer
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-  return true;
-}
-
-void OmniShadowMap::Write()
-{
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
-}
-
-void OmniShadowMap::Read(GLenum textureUnit)
-{
-  glActiveTexture(textureUnit);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMap);
-}
-
-OmniShadowMap::~OmniShadowMap(){}
-
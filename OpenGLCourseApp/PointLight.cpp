@@ -1,11 +1,22 @@
 #include "PointLight.h"
 
+#include "UniformState.h"
+
 PointLight::PointLight() : Light()
 {
   position = glm::vec3(0.0f, 0.0f, 0.0f);
   constant = 1.0f;  // we don't want to divide by 0
   linear = 0.0f;
   exponent = 0.0f;
+
+  nearPlane = 0.0f;
+  farPlane = 0.0f;
+  shadowSize = 0;
+  baseShadowSize = 0;
+  for (int i = 0; i < 6; i++)
+  {
+    shadowTiles[i].size = 0;
+  }
 }
 
 PointLight::PointLight(GLuint shadowWidth, GLuint shadowHeight,
@@ -14,13 +25,14 @@ PointLight::PointLight(GLuint shadowWidth, GLuint shadowHeight,
     GLfloat aIntensity, GLfloat dIntensity,
     GLfloat xPos, GLfloat yPos, GLfloat zPos,
     GLfloat con, GLfloat lin, GLfloat exp) :
-  Light(shadowWidth, shadowHeight, red, green, blue, aIntensity, dIntensity)
+  Light(red, green, blue, aIntensity, dIntensity)
 {
   position = glm::vec3(xPos, yPos, zPos);
   constant = con;
   linear = lin;
   exponent = exp;
 
+  nearPlane = near;
   farPlane = far;
 
   // idealy, this should be 1. Best for shadow width and height to be equal
@@ -28,8 +40,13 @@ PointLight::PointLight(GLuint shadowWidth, GLuint shadowHeight,
   float aspect = (float)shadowWidth / (float)shadowHeight;
   lightProj = glm::perspective(glm::radians(90.0f), aspect, near, far);
 
-  shadowMap = new OmniShadowMap();
-  shadowMap->Init(shadowWidth, shadowHeight);
+  // no texture of its own any more, it gets tiles in the shadow atlas
+  baseShadowSize = shadowWidth;
+  shadowSize = shadowWidth;
+  for (int i = 0; i < 6; i++)
+  {
+    shadowTiles[i].size = 0;
+  }
 }
 
 void PointLight::UseLight(GLuint ambientIntensityLocation,
@@ -40,14 +57,14 @@ void PointLight::UseLight(GLuint ambientIntensityLocation,
     GLuint linearLocation,
     GLuint exponentLocation)
 {
-  glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-  glUniform1f(ambientIntensityLocation, ambientIntensity);
-  glUniform1f(diffuseIntensityLocation, diffuseIntensity);
-
-  glUniform3f(positionLocation, position.x, position.y, position.z);
-  glUniform1f(constantLocation, constant);
-  glUniform1f(linearLocation, linear);
-  glUniform1f(exponentLocation, exponent);
+  UniformState::Set3f(ambientColorLocation, color.x, color.y, color.z);
+  UniformState::Set1f(ambientIntensityLocation, ambientIntensity);
+  UniformState::Set1f(diffuseIntensityLocation, diffuseIntensity);
+
+  UniformState::Set3f(positionLocation, position.x, position.y, position.z);
+  UniformState::Set1f(constantLocation, constant);
+  UniformState::Set1f(linearLocation, linear);
+  UniformState::Set1f(exponentLocation, exponent);
 }
 
 std::vector<glm::mat4> PointLight::CalculateLightTransform()
@@ -80,5 +97,45 @@ glm::vec3 PointLight::GetPosition()
   return position;
 }
 
+void PointLight::SetShadowQuality(const ShadowQuality& quality)
+{
+  shadowSize = (GLsizei)(baseShadowSize * quality.scale);
+}
+
+void PointLight::ClearShadowTiles()
+{
+  for (int i = 0; i < 6; i++)
+  {
+    shadowTiles[i].size = 0;
+    shadowTiles[i].rect = glm::vec4(0.0f);
+  }
+}
+
+GLfloat PointLight::GetRange()
+{
+  // The brightest this light can make a surface. Specular isn't scaled by
+  // the diffuse intensity in the shader, so count it at full strength.
+  GLfloat brightest = glm::max(color.x, glm::max(color.y, color.z));
+  GLfloat brightness = brightest * (ambientIntensity + diffuseIntensity + 1.0f);
+
+  // solve brightness / (exponent * d^2 + linear * d + constant) = 1 / 256,
+  // where it drops below the smallest step of an 8 bit color
+  GLfloat target = brightness * 256.0f;
+  GLfloat range = farPlane;
+
+  if (exponent > 0.0f)
+  {
+    GLfloat c = constant - target;
+    range = (-linear + sqrtf(linear * linear - 4.0f * exponent * c)) / (2.0f * exponent);
+  }
+  else if (linear > 0.0f)
+  {
+    range = (target - constant) / linear;
+  }
+
+  // the shadow map doesn't reach any further than this anyway
+  return glm::clamp(range, 0.0f, farPlane);
+}
+
 PointLight::~PointLight(){}
 
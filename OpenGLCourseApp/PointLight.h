@@ -2,7 +2,8 @@
 
 #include <vector>
 #include "Light.h"
-#include "OmniShadowMap.h"
+#include "ShadowAtlas.h"
+#include "ShadowQuality.h"
 
 class PointLight : public Light
 {
@@ -24,11 +25,28 @@ class PointLight : public Light
         GLuint exponentLocation);
 
     // remember, we're returning 6. Once for each side of our cube
-    std::vector<glm::mat4> CalculateLightTransform();
+    virtual std::vector<glm::mat4> CalculateLightTransform();
 
+    // Where this light's shadows are in the atlas this frame, one tile per
+    // matrix from CalculateLightTransform. Handed out by main each frame.
+    virtual int GetShadowTileCount() { return 6; }
+    ShadowTile* GetShadowTiles() { return shadowTiles; }
+    bool HasShadowTiles() { return shadowTiles[0].size > 0; }
+    void ClearShadowTiles();
+
+    // the biggest tile it should get, what it was created with scaled by
+    // the shadow quality
+    GLsizei GetShadowSize() { return shadowSize; }
+    void SetShadowQuality(const ShadowQuality& quality);
+
+    GLfloat GetNearPlane() { return nearPlane; }
     GLfloat GetFarPlane();
     glm::vec3 GetPosition();
 
+    // how far away the light still adds something visible, used to size
+    // its volume for deferred shading
+    GLfloat GetRange();
+
     ~PointLight();
 
   protected:
@@ -37,5 +55,8 @@ class PointLight : public Light
     // controls the attenuation of our light source
     GLfloat constant, linear, exponent;
 
-    GLfloat farPlane;
+    GLfloat nearPlane, farPlane;
+
+    ShadowTile shadowTiles[6];
+    GLsizei shadowSize, baseShadowSize;
 };
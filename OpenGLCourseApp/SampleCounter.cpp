@@ -0,0 +1,83 @@
+#include "SampleCounter.h"
+
+SampleCounter::SampleCounter()
+{
+  for (int i = 0; i < queryCount; i++)
+  {
+    queries[i] = 0;
+    pending[i] = false;
+  }
+
+  current = 0;
+  lastResult = 0;
+}
+
+void SampleCounter::Init()
+{
+  ClearCounter();
+  glGenQueries(queryCount, queries);
+}
+
+void SampleCounter::Begin()
+{
+  if (!queries[0])
+  {
+    return;
+  }
+
+  // pick up whatever has finished before reusing a query object
+  for (int i = 0; i < queryCount; i++)
+  {
+    int index = (current + 1 + i) % queryCount;
+    if (!pending[index])
+    {
+      continue;
+    }
+
+    GLuint available = 0;
+    glGetQueryObjectuiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+      glGetQueryObjectuiv(queries[index], GL_QUERY_RESULT, &lastResult);
+      pending[index] = false;
+    }
+  }
+
+  current = (current + 1) % queryCount;
+
+  // still not back after a whole ring of frames, just drop it
+  pending[current] = false;
+  glBeginQuery(GL_SAMPLES_PASSED, queries[current]);
+}
+
+void SampleCounter::End()
+{
+  if (!queries[0])
+  {
+    return;
+  }
+
+  glEndQuery(GL_SAMPLES_PASSED);
+  pending[current] = true;
+}
+
+void SampleCounter::ClearCounter()
+{
+  if (queries[0])
+  {
+    glDeleteQueries(queryCount, queries);
+  }
+
+  for (int i = 0; i < queryCount; i++)
+  {
+    queries[i] = 0;
+    pending[i] = false;
+  }
+
+  lastResult = 0;
+}
+
+SampleCounter::~SampleCounter()
+{
+  ClearCounter();
+}
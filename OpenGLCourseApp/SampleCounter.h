@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Counts the samples that pass the depth test between Begin and End, which
+// is how many fragments actually got shaded. Results are read a couple of
+// frames late so asking for them never stalls waiting on the GPU.
+class SampleCounter
+{
+  public:
+    SampleCounter();
+
+    void Init();
+
+    void Begin();
+    void End();
+
+    // the latest count the GPU has finished, 0 until the first one is ready
+    GLuint GetLastResult() { return lastResult; }
+
+    void ClearCounter();
+
+    ~SampleCounter();
+
+  private:
+    static const int queryCount = 3;
+
+    GLuint queries[queryCount];
+    bool pending[queryCount];
+    int current;
+
+    GLuint lastResult;
+};
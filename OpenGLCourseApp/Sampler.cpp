@@ -0,0 +1,95 @@
+#include "Sampler.h"
+
+std::map<SamplerState, Sampler*> Sampler::samplers;
+
+bool SamplerState::operator<(const SamplerState& other) const
+{
+  if (minFilter != other.minFilter) return minFilter < other.minFilter;
+  if (magFilter != other.magFilter) return magFilter < other.magFilter;
+  if (wrapS != other.wrapS) return wrapS < other.wrapS;
+  if (wrapT != other.wrapT) return wrapT < other.wrapT;
+  return anisotropy < other.anisotropy;
+}
+
+Sampler::Sampler(const SamplerState& state)
+{
+  glGenSamplers(1, &samplerID);
+
+  glSamplerParameteri(samplerID, GL_TEXTURE_WRAP_S, state.wrapS);
+  glSamplerParameteri(samplerID, GL_TEXTURE_WRAP_T, state.wrapT);
+  glSamplerParameteri(samplerID, GL_TEXTURE_MIN_FILTER, state.minFilter);
+  glSamplerParameteri(samplerID, GL_TEXTURE_MAG_FILTER, state.magFilter);
+
+  GLfloat maxAnisotropy = GetMaxAnisotropy();
+  if (maxAnisotropy > 1.0f && state.anisotropy > 1.0f)
+  {
+    GLfloat anisotropy = state.anisotropy < maxAnisotropy ? state.anisotropy : maxAnisotropy;
+    glSamplerParameterf(samplerID, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+  }
+}
+
+SamplerState Sampler::DefaultState()
+{
+  SamplerState state;
+
+  // blend between the two closest mip levels as well as within them. Without
+  // the mipmap part of the min filter the mip chain never gets used at all.
+  state.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+  state.magFilter = GL_LINEAR;
+
+  state.wrapS = GL_REPEAT;
+  state.wrapT = GL_REPEAT;
+
+  // keeps surfaces seen at a glancing angle (like the floor) sharp
+  state.anisotropy = 16.0f;
+
+  return state;
+}
+
+Sampler* Sampler::Get(const SamplerState& state)
+{
+  std::map<SamplerState, Sampler*>::iterator it = samplers.find(state);
+  if (it != samplers.end())
+  {
+    return it->second;
+  }
+
+  Sampler* sampler = new Sampler(state);
+  samplers[state] = sampler;
+  return sampler;
+}
+
+void Sampler::ClearSamplers()
+{
+  for (std::map<SamplerState, Sampler*>::iterator it = samplers.begin(); it != samplers.end(); ++it)
+  {
+    delete it->second;
+  }
+
+  samplers.clear();
+}
+
+void Sampler::Use(GLuint textureUnit)
+{
+  glBindSampler(textureUnit, samplerID);
+}
+
+GLfloat Sampler::GetMaxAnisotropy()
+{
+  // same enum for both the EXT and the ARB version of the extension
+  GLfloat maxAnisotropy = 1.0f;
+  if (GLEW_EXT_texture_filter_anisotropic || GLEW_ARB_texture_filter_anisotropic)
+  {
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+  }
+
+  return maxAnisotropy;
+}
+
+Sampler::~Sampler()
+{
+  if (samplerID)
+  {
+    glDeleteSamplers(1, &samplerID);
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+
+#include <GL/glew.h>
+
+// Everything that decides how a texture gets filtered and wrapped.
+// Two materials asking for the same state end up sharing one sampler object.
+struct SamplerState
+{
+  GLint minFilter;
+  GLint magFilter;
+  GLint wrapS;
+  GLint wrapT;
+  // 1.0 turns anisotropic filtering off, it gets clamped to what the driver supports
+  GLfloat anisotropy;
+
+  bool operator<(const SamplerState& other) const;
+};
+
+class Sampler
+{
+  public:
+    // trilinear filtering with as much anisotropy as the driver allows
+    static SamplerState DefaultState();
+
+    // returns the sampler for this state, creating it the first time around
+    static Sampler* Get(const SamplerState& state);
+    static void ClearSamplers();
+
+    void Use(GLuint textureUnit);
+
+    GLuint GetSamplerID() { return samplerID; }
+
+    ~Sampler();
+
+  private:
+    Sampler(const SamplerState& state);
+
+    static GLfloat GetMaxAnisotropy();
+
+    GLuint samplerID;
+
+    static std::map<SamplerState, Sampler*> samplers;
+};
@@ -1,10 +1,27 @@
 #include "Shader.h"
 
+#include <algorithm>
+
+#include "FileSystem.h"
+#include "ShaderCache.h"
+#include "ShaderIncludes.h"
+#include "ShaderWatcher.h"
+#include "TextureTable.h"
+#include "DrawData.h"
+#include "UniformState.h"
+
 Shader::Shader()
 {
   shaderID = 0;
   uniformModel = 0;
   uniformProjection = 0;
+  uniformTextureIndex = -1;
+  uniformDrawID = -1;
+  uniformShadowAtlas = -1;
+  uniformLightMatrix = -1;
+
+  linkPending = false;
+  cacheKey = 0;
 
   pointLightCount = 0;
   spotLightCount = 0;
@@ -65,14 +82,9 @@ GLuint Shader::GetEyePositionLocation()
   return uniformEyePosition;
 }
 
-GLuint Shader::GetOmniLightPosLocation()
+GLuint Shader::GetTextureIndexLocation()
 {
-  return uniformOmniLightPos;
-}
-
-GLuint Shader::GetFarPlaneLocation()
-{
-  return uniformFarPlane;
+  return uniformTextureIndex;
 }
 
 void Shader::SetDirectionalLight(DirectionalLight* dLight)
@@ -85,7 +97,6 @@ void Shader::SetDirectionalLight(DirectionalLight* dLight)
 
 void Shader::SetPointLights(PointLight* pLight,
     unsigned int lightCount,
-    unsigned int textureUnit,
     unsigned int offset)
 {
   if (lightCount > MAX_POINT_LIGHTS)
@@ -93,7 +104,7 @@ void Shader::SetPointLights(PointLight* pLight,
     lightCount = MAX_POINT_LIGHTS;
   }
 
-  glUniform1i(uniformPointLightCount, lightCount);
+  UniformState::Set1i(uniformPointLightCount, lightCount);
 
   for (size_t i = 0; i < lightCount; i++)
   {
@@ -106,17 +117,21 @@ void Shader::SetPointLights(PointLight* pLight,
         uniformPointLight[i].uniformLinear,
         uniformPointLight[i].uniformExponent);
 
-    pLight[i].GetShadowMap()->Read(GL_TEXTURE0 + textureUnit + i);
-    // notice, we don't use GL_TEXTURE0. It doesn't have to be an enum type!
-    // also, GL_TEXTURE0 is actually 0x84C0. So, we're not starting from 0 anyways.
-    glUniform1i(uniformOmniShadowMap[i + offset].shadowMap, textureUnit + i);
-    glUniform1i(uniformOmniShadowMap[i + offset].farPlane, pLight[i].GetFarPlane());
+    // the six faces of its cube, as tiles in the shadow atlas
+    ShadowTile* tiles = pLight[i].GetShadowTiles();
+    for (size_t face = 0; face < 6; face++)
+    {
+      UniformState::Set4f(uniformOmniShadowMap[i + offset].tiles[face],
+          tiles[face].rect.x, tiles[face].rect.y, tiles[face].rect.z, tiles[face].rect.w);
+    }
+
+    UniformState::Set1f(uniformOmniShadowMap[i + offset].nearPlane, pLight[i].GetNearPlane());
+    UniformState::Set1f(uniformOmniShadowMap[i + offset].farPlane, pLight[i].GetFarPlane());
   }
 }
 
 void Shader::SetSpotLights(SpotLight* sLight,
     unsigned int lightCount,
-    unsigned int textureUnit,
     unsigned int offset)
 {
   if (lightCount > MAX_SPOT_LIGHTS)
@@ -124,7 +139,7 @@ void Shader::SetSpotLights(SpotLight* sLight,
     lightCount = MAX_SPOT_LIGHTS;
   }
 
-  glUniform1i(uniformSpotLightCount, lightCount);
+  UniformState::Set1i(uniformSpotLightCount, lightCount);
 
   for (size_t i = 0; i < lightCount; i++)
   {
@@ -139,94 +154,223 @@ void Shader::SetSpotLights(SpotLight* sLight,
         uniformSpotLight[i].uniformExponent,
         uniformSpotLight[i].uniformEdge);
 
-    sLight[i].GetShadowMap()->Read(GL_TEXTURE0 + textureUnit + i);
-    glUniform1i(uniformOmniShadowMap[i + offset].shadowMap, textureUnit + i);
-    glUniform1i(uniformOmniShadowMap[i + offset].farPlane, sLight[i].GetFarPlane());
+    // just the one tile, looked up through the matrix it was drawn with.
+    // It holds plain depth, so there's no far plane to scale by.
+    ShadowTile* tiles = sLight[i].GetShadowTiles();
+    glm::mat4 lightMatrix = sLight[i].CalculateLightTransform()[0];
+
+    UniformState::Set4f(uniformOmniShadowMap[i + offset].tiles[0],
+        tiles[0].rect.x, tiles[0].rect.y, tiles[0].rect.z, tiles[0].rect.w);
+    UniformState::SetMatrix4fv(uniformOmniShadowMap[i + offset].lightMatrix, glm::value_ptr(lightMatrix));
   }
 }
 
 void Shader::SetTexture(GLuint textureUnit)
 {
-  glUniform1i(uniformTexture, textureUnit);
+  UniformState::Set1i(uniformTexture, textureUnit);
 }
 
 void Shader::SetDirectionalShadowMap(GLuint textureUnit)
 {
-  glUniform1i(uniformDirectionalShadowMap, textureUnit);
+  UniformState::Set1i(uniformDirectionalShadowMap, textureUnit);
 }
 
 void Shader::SetDirectionalLightTransform(glm::mat4* lTransform)
 {
-  glUniformMatrix4fv(
+  UniformState::SetMatrix4fv(
       uniformDirectionalLightTransform,
-      1,
-      GL_FALSE,
       glm::value_ptr(*lTransform));
 }
 
-void Shader::SetLightMatrices(std::vector<glm::mat4> lightMatrices)
+void Shader::SetShadowAtlas(GLuint textureUnit)
+{
+  UniformState::Set1i(uniformShadowAtlas, textureUnit);
+}
+
+void Shader::SetLightMatrix(glm::mat4* lightMatrix)
+{
+  UniformState::SetMatrix4fv(uniformLightMatrix, glm::value_ptr(*lightMatrix));
+}
+
+bool Shader::IsReady()
 {
-  for (size_t i = 0; i < 6; i++)
+  if (!linkPending)
   {
-    glUniformMatrix4fv(
-        uniformLightMatrices[i],
-        1,
-        GL_FALSE,
-        glm::value_ptr(lightMatrices[i]));
+    return true;
   }
+
+  // without the extension there's no way to ask, so just wait for it here
+  if (GLEW_KHR_parallel_shader_compile)
+  {
+    GLint completed = 0;
+    glGetProgramiv(shaderID, GL_COMPLETION_STATUS_KHR, &completed);
+    if (!completed)
+    {
+      return false;
+    }
+  }
+
+  FinishProgram();
+  return true;
 }
 
 void Shader::UseShader()
 {
-  glUseProgram(shaderID);
+  // first use of a program still being built, this is where we finally wait
+  if (linkPending)
+  {
+    FinishProgram();
+  }
+
+  UniformState::UseProgram(shaderID);
+
+  // textures set their table entry and draws their id through whichever
+  // program is in use
+  TextureTable::SetIndexLocation(uniformTextureIndex);
+  DrawData::SetIDLocation(uniformDrawID);
 }
 
 void Shader::ClearShader()
 {
   if (shaderID != 0)
   {
+    UniformState::ForgetProgram(shaderID);
     glDeleteProgram(shaderID);
     shaderID = 0;
   }
 
+  linkPending = false;
+
   uniformModel = 0;
   uniformProjection = 0;
 }
 
 Shader::~Shader()
 {
+  ShaderWatcher::Unwatch(this);
   ClearShader();
 }
 
 void Shader::CreateFromFiles(const char* vertexLocation,
     const char* fragmentLocation)
 {
-  std::string vertexString = ReadFile(vertexLocation);
-  std::string fragmentString = ReadFile(fragmentLocation);
+  sourceFiles.clear();
+  sourceFiles.push_back(vertexLocation);
+  sourceFiles.push_back(fragmentLocation);
 
-  const char* vertexCode = vertexString.c_str();
-  const char* fragmentCode = fragmentString.c_str();
-
-  CompileShader(vertexCode, fragmentCode);
+  LoadFiles(false);
+  WatchFiles();
 }
 
 void Shader::CreateFromFiles(const char* vertexLocation,
     const char* geometryLocation,
     const char* fragmentLocation)
 {
-  std::string vertexString = ReadFile(vertexLocation);
-  std::string geometryString = ReadFile(geometryLocation);
-  std::string fragmentString = ReadFile(fragmentLocation);
+  sourceFiles.clear();
+  sourceFiles.push_back(vertexLocation);
+  sourceFiles.push_back(geometryLocation);
+  sourceFiles.push_back(fragmentLocation);
+
+  LoadFiles(false);
+  WatchFiles();
+}
+
+void Shader::LoadFiles(bool fromDisk)
+{
+  stageFiles.assign(sourceFiles.size(), std::vector<std::string>());
+
+  std::string vertexString = ReadFile(sourceFiles[0].c_str(), fromDisk, &stageFiles[0]);
+  std::string fragmentString = ReadFile(sourceFiles.back().c_str(), fromDisk, &stageFiles.back());
 
   const char* vertexCode = vertexString.c_str();
-  const char* geometryCode = geometryString.c_str();
   const char* fragmentCode = fragmentString.c_str();
 
-  CompileShader(vertexCode, geometryCode, fragmentCode);
+  if (sourceFiles.size() == 3)
+  {
+    std::string geometryString = ReadFile(sourceFiles[1].c_str(), fromDisk, &stageFiles[1]);
+    CompileShader(vertexCode, geometryString.c_str(), fragmentCode);
+  }
+  else
+  {
+    CompileShader(vertexCode, fragmentCode);
+  }
+}
+
+void Shader::WatchFiles()
+{
+  // saving a shared include rebuilds everything that uses it
+  std::vector<std::string> files;
+  for (size_t i = 0; i < stageFiles.size(); i++)
+  {
+    for (size_t j = 0; j < stageFiles[i].size(); j++)
+    {
+      const std::string& file = stageFiles[i][j];
+      if (!ShaderIncludes::IsGenerated(file) &&
+          std::find(files.begin(), files.end(), file) == files.end())
+      {
+        files.push_back(file);
+      }
+    }
+  }
+
+  ShaderWatcher::Watch(this, files);
+}
+
+bool Shader::Reload()
+{
+  if (sourceFiles.empty())
+  {
+    return false;
+  }
+
+  // keep the working program around until we know the new one links
+  GLuint oldShaderID = shaderID;
+  bool oldLinkPending = linkPending;
+  uint64_t oldCacheKey = cacheKey;
+
+  // read straight from disk, the pack still has the old version
+  shaderID = 0;
+  linkPending = false;
+  LoadFiles(true);
+
+  // the edit may have added or removed includes
+  WatchFiles();
+
+  // a program that came out of the binary cache is already finished
+  if (!shaderID || (linkPending && !FinishProgram()))
+  {
+    printf("Reloading %s failed, keeping the old program\n", sourceFiles.back().c_str());
+
+    if (shaderID)
+    {
+      glDeleteProgram(shaderID);
+    }
+
+    shaderID = oldShaderID;
+    linkPending = oldLinkPending;
+    cacheKey = oldCacheKey;
+    return false;
+  }
+
+  // FinishProgram already picked up the uniform locations of the new
+  // program. If the old one is still bound GL frees it once it's unbound.
+  if (oldShaderID)
+  {
+    UniformState::ForgetProgram(oldShaderID);
+    glDeleteProgram(oldShaderID);
+  }
+
+  printf("Reloaded %s\n", sourceFiles.back().c_str());
+  return true;
 }
 
 void Shader::Validate()
 {
+  if (linkPending)
+  {
+    FinishProgram();
+  }
+
   // tracking errors
   GLint result = 0;
   GLchar eLog[1024] = { 0 };
@@ -246,49 +390,53 @@ void Shader::Validate()
   }
 }
 
-std::string Shader::ReadFile(const char* fileLocation)
+std::string Shader::ReadFile(const char* fileLocation, bool fromDisk,
+    std::vector<std::string>* files)
 {
-  std::string content;
-  std::ifstream fileStream(fileLocation, std::ios::in);
+  AssetFile file;
+  bool found = fromDisk ?
+    FileSystem::ReadLooseFile(fileLocation, file) :
+    FileSystem::ReadFile(fileLocation, file);
 
-  if (!fileStream.is_open())
+  if (!found)
   {
     printf("Failed to read %s! File doesn't exist\n", fileLocation);
     return "";
   }
 
-  std::string line = "";
-  while (!fileStream.eof())
+  std::vector<std::string> included;
+  std::string source = ShaderIncludes::Process(fileLocation, file.GetString(), fromDisk, included);
+
+  if (files)
   {
-    std::getline(fileStream, line);
-    content.append(line + "\n");
+    files->swap(included);
   }
 
-  fileStream.close();
-  return content;
+  return source;
 }
 
 void Shader::CompileShader(const char* vertexCode, const char* fragmentCode)
 {
-  // creates a new shader program and obtains the ID
-  // remember! These programs live on the VRAM
-  shaderID = glCreateProgram();
-
-  if (!shaderID)
-  {
-    printf("Error creating shader program!\n");
-    return;
-  }
-
-  AddShader(shaderID, vertexCode, GL_VERTEX_SHADER);
-  AddShader(shaderID, fragmentCode, GL_FRAGMENT_SHADER);
+  std::vector<ShaderStage> stages;
+  stages.push_back(ShaderStage(GL_VERTEX_SHADER, InsertDefines(vertexCode)));
+  stages.push_back(ShaderStage(GL_FRAGMENT_SHADER, InsertDefines(fragmentCode)));
 
-  CompileProgram();
+  BuildProgram(stages);
 }
 
 void Shader::CompileShader(const char* vertexCode,
     const char* geometryCode,
     const char* fragmentCode)
+{
+  std::vector<ShaderStage> stages;
+  stages.push_back(ShaderStage(GL_VERTEX_SHADER, InsertDefines(vertexCode)));
+  stages.push_back(ShaderStage(GL_GEOMETRY_SHADER, InsertDefines(geometryCode)));
+  stages.push_back(ShaderStage(GL_FRAGMENT_SHADER, InsertDefines(fragmentCode)));
+
+  BuildProgram(stages);
+}
+
+void Shader::BuildProgram(const std::vector<ShaderStage>& stages)
 {
   // creates a new shader program and obtains the ID
   // remember! These programs live on the VRAM
@@ -300,154 +448,229 @@ void Shader::CompileShader(const char* vertexCode,
     return;
   }
 
-  AddShader(shaderID, vertexCode, GL_VERTEX_SHADER);
-  AddShader(shaderID, geometryCode, GL_GEOMETRY_SHADER);
-  AddShader(shaderID, fragmentCode, GL_FRAGMENT_SHADER);
+  // a binary from a previous run lets us skip compiling and linking entirely
+  std::vector<std::string> sources;
+  for (size_t i = 0; i < stages.size(); i++)
+  {
+    sources.push_back(stages[i].second);
+  }
+
+  cacheKey = ShaderCache::MakeKey(sources);
+  if (ShaderCache::Load(shaderID, cacheKey))
+  {
+    GetUniformLocations();
+    return;
+  }
+
+  for (size_t i = 0; i < stages.size(); i++)
+  {
+    AddShader(shaderID, stages[i].second.c_str(), stages[i].first);
+  }
 
+  ShaderCache::PrepareForSave(shaderID);
   CompileProgram();
 }
 
 void Shader::CompileProgram()
 {
+  // Let the driver compile on as many threads as it likes. Only needs doing
+  // once, but it's harmless to repeat.
+  if (GLEW_KHR_parallel_shader_compile)
+  {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+
+  // this will create the executables on the graphics card. We don't ask how
+  // it went until the program is first used, so the driver can keep working
+  // on it (and every other program) while we get on with loading the scene.
+  glLinkProgram(shaderID);
+  linkPending = true;
+}
+
+bool Shader::FinishProgram()
+{
+  linkPending = false;
+
   // tracking errors
   GLint result = 0;
   GLchar eLog[1024] = { 0 };
 
-  // this will create the executables on the graphics card
-  glLinkProgram(shaderID);
-  // check to see if everything was linked correctly
+  // check to see if everything was linked correctly, this blocks if the
+  // driver hasn't finished yet
   glGetProgramiv(shaderID, GL_LINK_STATUS, &result);
 
   // if result is 0, then something went wrong!
   if (!result)
   {
+    // a stage that didn't compile is the usual reason, so report those first
+    GLuint shaders[8];
+    GLsizei shaderCount = 0;
+    glGetAttachedShaders(shaderID, 8, &shaderCount, shaders);
+
+    for (GLsizei i = 0; i < shaderCount; i++)
+    {
+      GLint compiled = 0;
+      glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+      if (!compiled)
+      {
+        GLint shaderType = 0;
+        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &shaderType);
+        glGetShaderInfoLog(shaders[i], sizeof(eLog), NULL, eLog);
+
+        // stages are in the same order as sourceFiles
+        size_t stage = shaderType == GL_VERTEX_SHADER ? 0 :
+          (shaderType == GL_GEOMETRY_SHADER ? 1 : stageFiles.size() - 1);
+
+        if (stage < stageFiles.size())
+        {
+          std::string log = ShaderIncludes::RemapLog(eLog, stageFiles[stage]);
+          printf("Error compiling the %d shader: '%s'\n", shaderType, log.c_str());
+        }
+        else
+        {
+          printf("Error compiling the %d shader: '%s'\n", shaderType, eLog);
+        }
+      }
+    }
+
     // get the error log
     glGetProgramInfoLog(shaderID, sizeof(eLog), NULL, eLog);
     printf("Error linking program: '%s'\n", eLog);
-    return;
+    return false;
   }
 
+  ShaderCache::Save(shaderID, cacheKey);
+  GetUniformLocations();
+  return true;
+}
+
+void Shader::GetUniformLocations()
+{
+  // one pass over what the program actually uses, everything below is just
+  // a table lookup. Names the program doesn't have come back as -1.
+  uniforms.Build(shaderID);
+
   // get uniform IDs
-  uniformModel = glGetUniformLocation(shaderID, "model");
-  uniformProjection = glGetUniformLocation(shaderID, "projection");
-  uniformView = glGetUniformLocation(shaderID, "view");
-  uniformSpecularIntensity = glGetUniformLocation(shaderID, "material.specularIntensity");
-  uniformShininess = glGetUniformLocation(shaderID, "material.shininess");
-  uniformEyePosition = glGetUniformLocation(shaderID, "eyePosition");
-
-  uniformDirectionalLight.uniformColor = glGetUniformLocation(shaderID, "directionalLight.base.color");
-  uniformDirectionalLight.uniformAmbientIntensity = glGetUniformLocation(shaderID, "directionalLight.base.ambientIntensity");
-  uniformDirectionalLight.uniformDirection = glGetUniformLocation(shaderID, "directionalLight.direction");
-  uniformDirectionalLight.uniformDiffuseIntensity = glGetUniformLocation(shaderID, "directionalLight.base.diffuseIntensity");
+  uniformModel = uniforms.Find(UNIFORM_ID("model"));
+  uniformProjection = uniforms.Find(UNIFORM_ID("projection"));
+  uniformView = uniforms.Find(UNIFORM_ID("view"));
+  uniformSpecularIntensity = uniforms.Find(UNIFORM_ID("material.specularIntensity"));
+  uniformShininess = uniforms.Find(UNIFORM_ID("material.shininess"));
+  uniformEyePosition = uniforms.Find(UNIFORM_ID("eyePosition"));
+
+  uniformDirectionalLight.uniformColor = uniforms.Find(UNIFORM_ID("directionalLight.base.color"));
+  uniformDirectionalLight.uniformAmbientIntensity = uniforms.Find(UNIFORM_ID("directionalLight.base.ambientIntensity"));
+  uniformDirectionalLight.uniformDirection = uniforms.Find(UNIFORM_ID("directionalLight.direction"));
+  uniformDirectionalLight.uniformDiffuseIntensity = uniforms.Find(UNIFORM_ID("directionalLight.base.diffuseIntensity"));
 
   // Setup all the Point Lights in the scene
-  uniformPointLightCount = glGetUniformLocation(shaderID, "pointLightCount");
-  for (size_t i = 0; i < MAX_POINT_LIGHTS; i++)
+  uniformPointLightCount = uniforms.Find(UNIFORM_ID("pointLightCount"));
+  for (int i = 0; i < MAX_POINT_LIGHTS; i++)
   {
-    char locBuff[100] = {'\0'};
-
-    // get uniform location for color
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.color", i);
-    uniformPointLight[i].uniformColor = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for ambient intensity
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.ambientIntensity", i);
-    uniformPointLight[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for diffuse intensity
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].base.diffuseIntensity", i);
-    uniformPointLight[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for position
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].position", i);
-    uniformPointLight[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for constant
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].constant", i);
-    uniformPointLight[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for linear
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].linear", i);
-    uniformPointLight[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for exponent
-    snprintf(locBuff, sizeof(locBuff), "pointLights[%d].exponent", i);
-    uniformPointLight[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+    uniformPointLight[i].uniformColor = uniforms.Find(HashUniformIndexed("pointLights", i, ".base.color"));
+    uniformPointLight[i].uniformAmbientIntensity = uniforms.Find(HashUniformIndexed("pointLights", i, ".base.ambientIntensity"));
+    uniformPointLight[i].uniformDiffuseIntensity = uniforms.Find(HashUniformIndexed("pointLights", i, ".base.diffuseIntensity"));
+    uniformPointLight[i].uniformPosition = uniforms.Find(HashUniformIndexed("pointLights", i, ".position"));
+    uniformPointLight[i].uniformConstant = uniforms.Find(HashUniformIndexed("pointLights", i, ".constant"));
+    uniformPointLight[i].uniformLinear = uniforms.Find(HashUniformIndexed("pointLights", i, ".linear"));
+    uniformPointLight[i].uniformExponent = uniforms.Find(HashUniformIndexed("pointLights", i, ".exponent"));
   }
 
-
   // Setup all the Spot Lights in the scene
-  uniformSpotLightCount = glGetUniformLocation(shaderID, "spotLightCount");
-  for (size_t i = 0; i < MAX_SPOT_LIGHTS; i++)
+  uniformSpotLightCount = uniforms.Find(UNIFORM_ID("spotLightCount"));
+  for (int i = 0; i < MAX_SPOT_LIGHTS; i++)
   {
-    char locBuff[100] = {'\0'};
-
-    // get uniform location for color
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.base.color", i);
-    uniformSpotLight[i].uniformColor = glGetUniformLocation(shaderID, locBuff);
-
-    // get uniform location for ambient intensity
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.base.ambientIntensity", i);
-    uniformSpotLight[i].uniformAmbientIntensity = glGetUniformLocation(shaderID, locBuff);
+    uniformSpotLight[i].uniformColor = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.base.color"));
+    uniformSpotLight[i].uniformAmbientIntensity = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.base.ambientIntensity"));
+    uniformSpotLight[i].uniformDiffuseIntensity = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.base.diffuseIntensity"));
+    uniformSpotLight[i].uniformPosition = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.position"));
+    uniformSpotLight[i].uniformConstant = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.constant"));
+    uniformSpotLight[i].uniformLinear = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.linear"));
+    uniformSpotLight[i].uniformExponent = uniforms.Find(HashUniformIndexed("spotLights", i, ".base.exponent"));
+    uniformSpotLight[i].uniformDirection = uniforms.Find(HashUniformIndexed("spotLights", i, ".direction"));
+    uniformSpotLight[i].uniformEdge = uniforms.Find(HashUniformIndexed("spotLights", i, ".edge"));
+  }
 
-    // get uniform location for diffuse intensity
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.base.diffuseIntensity", i);
-    uniformSpotLight[i].uniformDiffuseIntensity = glGetUniformLocation(shaderID, locBuff);
+  // Bind uniforms for textures
+  uniformTexture = uniforms.Find(UNIFORM_ID("theTexture"));
+  uniformDirectionalLightTransform = uniforms.Find(UNIFORM_ID("directionalLightTransform"));
+  uniformDirectionalShadowMap = uniforms.Find(UNIFORM_ID("directionalShadowMap"));
 
-    // get uniform location for position
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.position", i);
-    uniformSpotLight[i].uniformPosition = glGetUniformLocation(shaderID, locBuff);
+  // the face (or spot light) being drawn into the shadow atlas
+  uniformLightMatrix = uniforms.Find(UNIFORM_ID("lightMatrix"));
 
-    // get uniform location for constant
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.constant", i);
-    uniformSpotLight[i].uniformConstant = glGetUniformLocation(shaderID, locBuff);
+  // Get the uniforms for the omni shadows, all of them in the one atlas
+  uniformShadowAtlas = uniforms.Find(UNIFORM_ID("shadowAtlas"));
+  for (int i = 0; i < MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS; i++)
+  {
+    static const char* tileNames[6] = {
+      ".tiles[0]", ".tiles[1]", ".tiles[2]", ".tiles[3]", ".tiles[4]", ".tiles[5]"
+    };
+
+    for (int face = 0; face < 6; face++)
+    {
+      uniformOmniShadowMap[i].tiles[face] = uniforms.Find(HashUniformIndexed("omniShadowMaps", i, tileNames[face]));
+    }
+
+    uniformOmniShadowMap[i].lightMatrix = uniforms.Find(HashUniformIndexed("omniShadowMaps", i, ".lightMatrix"));
+    uniformOmniShadowMap[i].nearPlane = uniforms.Find(HashUniformIndexed("omniShadowMaps", i, ".nearPlane"));
+    uniformOmniShadowMap[i].farPlane = uniforms.Find(HashUniformIndexed("omniShadowMaps", i, ".farPlane"));
+  }
 
-    // get uniform location for linear
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.linear", i);
-    uniformSpotLight[i].uniformLinear = glGetUniformLocation(shaderID, locBuff);
+  // Per-draw data, the index into the draw block
+  uniformDrawID = uniforms.Find(UNIFORM_ID("drawID"));
 
-    // get uniform location for exponent
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].base.exponent", i);
-    uniformSpotLight[i].uniformExponent = glGetUniformLocation(shaderID, locBuff);
+  GLuint drawBlock = glGetUniformBlockIndex(shaderID, "DrawBlock");
+  if (drawBlock != GL_INVALID_INDEX)
+  {
+    glUniformBlockBinding(shaderID, drawBlock, DRAW_DATA_BINDING);
+  }
 
-    // get uniform location for direction
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].direction", i);
-    uniformSpotLight[i].uniformDirection = glGetUniformLocation(shaderID, locBuff);
+  // Texture table, only there when built with the TEXTURE_TABLE_* defines
+  uniformTextureIndex = uniforms.Find(UNIFORM_ID("textureIndex"));
 
-    // get uniform location for edge
-    snprintf(locBuff, sizeof(locBuff), "spotLights[%d].edge", i);
-    uniformSpotLight[i].uniformEdge = glGetUniformLocation(shaderID, locBuff);
+  GLuint tableBlock = glGetUniformBlockIndex(shaderID, "TextureTable");
+  if (tableBlock != GL_INVALID_INDEX)
+  {
+    glUniformBlockBinding(shaderID, tableBlock, TEXTURE_TABLE_BINDING);
   }
 
-  // Bind uniforms for textures
-  uniformTexture = glGetUniformLocation(shaderID, "theTexture");
-  uniformDirectionalLightTransform = glGetUniformLocation(shaderID, "directionalLightTransform");
-  uniformDirectionalShadowMap = glGetUniformLocation(shaderID, "directionalShadowMap");
+  // the array samplers never move, so point them at their units once
+  if (uniforms.Find(UNIFORM_ID("textureArrays")) >= 0)
+  {
+    UniformState::UseProgram(shaderID);
+    for (int i = 0; i < MAX_TEXTURE_ARRAYS; i++)
+    {
+      UniformState::Set1i(uniforms.Find(HashUniformIndexed("textureArrays", i, "")), TEXTURE_ARRAY_UNIT + i);
+    }
+    UniformState::UseProgram(0);
+  }
+}
 
-  // Bind uniforms for omni-light shadows
-  uniformOmniLightPos = glGetUniformLocation(shaderID, "lightPos");
-  uniformFarPlane = glGetUniformLocation(shaderID, "farPlane");
+GLint Shader::GetUniformLocation(uint32_t id)
+{
+  return uniforms.Find(id);
+}
 
-  // Now for each light matrix for our cubemap
-  for (size_t i = 0; i < 6; i++)
+std::string Shader::InsertDefines(const char* shaderCode)
+{
+  std::string code = shaderCode;
+  if (defines.empty())
   {
-    char locBuff[100] = { '\0' };
-
-    snprintf(locBuff, sizeof(locBuff), "lightMatrices[%d]", i);
-    uniformLightMatrices[i] = glGetUniformLocation(shaderID, locBuff);
+    return code;
   }
 
-  // Get the uniforms for the omni shadows
-  for (size_t i = 0; i < MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS; i++)
+  // #version has to stay the very first thing in the source
+  size_t insertAt = 0;
+  size_t version = code.find("#version");
+  if (version != std::string::npos)
   {
-    char locBuff[100] = { '\0' };
-
-    snprintf(locBuff, sizeof(locBuff), "omniShadowMaps[%d].shadowMap", i);
-    uniformOmniShadowMap[i].shadowMap = glGetUniformLocation(shaderID, locBuff);
-
-    snprintf(locBuff, sizeof(locBuff), "omniShadowMaps[%d].farPlane", i);
-    uniformOmniShadowMap[i].farPlane = glGetUniformLocation(shaderID, locBuff);
+    size_t lineEnd = code.find('\n', version);
+    insertAt = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
   }
+
+  code.insert(insertAt, defines);
+  return code;
 }
 
 void Shader::AddShader(GLuint theProgram, const char* shaderCode, GLenum shaderType)
@@ -460,22 +683,12 @@ void Shader::AddShader(GLuint theProgram, const char* shaderCode, GLenum shaderT
   codeLength[0] = strlen(shaderCode);
 
   glShaderSource(theShader, 1, theCode, codeLength);
+  // compile errors get checked in FinishProgram, asking now would make us
+  // wait on the driver
   glCompileShader(theShader);
 
-  // tracking errors
-  GLint result = 0;
-  GLchar eLog[1024] = { 0 };
-
-  glGetShaderiv(theShader, GL_COMPILE_STATUS, &result);
-
-  // if result is 0, then something went wrong!
-  if (!result)
-  {
-    // get the error log
-    glGetShaderInfoLog(theShader, sizeof(eLog), NULL, eLog);
-    printf("Error compiling the %d shader: '%s'\n", shaderType, eLog);
-    return;
-  }
-
   glAttachShader(theProgram, theShader);
+
+  // the program holds on to it now, it'll be freed along with the program
+  glDeleteShader(theShader);
 }
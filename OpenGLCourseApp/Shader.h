@@ -1,9 +1,13 @@
 #pragma once
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -11,6 +15,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "CommonValues.h"
+#include "UniformTable.h"
 
 #include "DirectionalLight.h"
 #include "PointLight.h"
@@ -28,9 +33,24 @@ class Shader
         const char* geometryLocation,
         const char* fragmentLocation);
 
+    // extra #defines (one per line) that get placed right after the #version
+    // line of every stage. Has to be set before creating the shader.
+    void SetDefines(const std::string& defineBlock) { defines = defineBlock; }
+
     void Validate();
 
-    std::string ReadFile(const char* fileLocation);
+    // Programs are built in the background where the driver supports it.
+    // True once this one is done, never blocks. UseShader will wait for it.
+    bool IsReady();
+
+    // rebuilds from the files it was created from, the current program is
+    // kept if the new one doesn't compile. Called by ShaderWatcher.
+    bool Reload();
+
+    // Resolves #include "file" as it goes (see ShaderIncludes.h). files
+    // gets every file that went into the result, in source string order.
+    std::string ReadFile(const char* fileLocation, bool fromDisk = false,
+        std::vector<std::string>* files = nullptr);
 
     GLuint GetProjectionLocation();
     GLuint GetModelLocation();
@@ -42,25 +62,28 @@ class Shader
     GLuint GetSpecularIntensityLocation();
     GLuint GetShininessLocation();
     GLuint GetEyePositionLocation();
-    GLuint GetOmniLightPosLocation();
-    GLuint GetFarPlaneLocation();
+    GLuint GetTextureIndexLocation();
+
+    // any other uniform, e.g. GetUniformLocation(UNIFORM_ID("farPlane"))
+    GLint GetUniformLocation(uint32_t id);
 
     void SetDirectionalLight(DirectionalLight* dLight);
 
+    // offset is where the lights start in omniShadowMaps, point lights
+    // come first and spot lights after them
     void SetPointLights(PointLight* pLight,
         unsigned int lightCount,
-        unsigned int textureUnit,
         unsigned int offset);
 
     void SetSpotLights(SpotLight* sLight,
         unsigned int lightCount,
-        unsigned int textureUnit,
         unsigned int offset);
 
     void SetTexture(GLuint textureUnit);
     void SetDirectionalShadowMap(GLuint textureUnit);
     void SetDirectionalLightTransform(glm::mat4* lTransform);
-    void SetLightMatrices(std::vector<glm::mat4> lightMatrices);
+    void SetShadowAtlas(GLuint textureUnit);
+    void SetLightMatrix(glm::mat4* lightMatrix);
 
     void UseShader();
     void ClearShader();
@@ -71,6 +94,23 @@ class Shader
     int pointLightCount;
     int spotLightCount;
 
+    std::string defines;
+
+    GLint uniformDrawID;
+
+    // every active uniform of the linked program
+    UniformTable uniforms;
+
+    // what CreateFromFiles was given: vertex, (geometry,) fragment
+    std::vector<std::string> sourceFiles;
+    // and for each of those, every file it included. Turns the numbers in
+    // compile errors back into names.
+    std::vector<std::vector<std::string> > stageFiles;
+
+    // linked but not checked yet, uniform locations aren't valid until then
+    bool linkPending;
+    uint64_t cacheKey;
+
     GLuint shaderID,
            uniformProjection,
            uniformModel,
@@ -81,10 +121,9 @@ class Shader
            uniformTexture,
            uniformDirectionalShadowMap,
            uniformDirectionalLightTransform,
-           uniformOmniLightPos,
-           uniformFarPlane;
-
-    GLuint uniformLightMatrices[6];
+           uniformTextureIndex,
+           uniformShadowAtlas,
+           uniformLightMatrix;
 
     struct {
       GLuint uniformColor;
@@ -124,7 +163,9 @@ class Shader
     } uniformSpotLight[MAX_SPOT_LIGHTS];
 
     struct {
-      GLuint shadowMap;
+      GLuint tiles[6];
+      GLuint lightMatrix;
+      GLuint nearPlane;
       GLuint farPlane;
     } uniformOmniShadowMap[MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS];
 
@@ -134,7 +175,17 @@ class Shader
         const char* geometryCode,
         const char* fragmentCode);
 
+    // stage type and its final source, defines already inserted
+    typedef std::pair<GLenum, std::string> ShaderStage;
+
+    void LoadFiles(bool fromDisk);
+    void WatchFiles();
+
+    std::string InsertDefines(const char* shaderCode);
+    void BuildProgram(const std::vector<ShaderStage>& stages);
     void AddShader(GLuint theProgram, const char* shaderCode, GLenum shaderType);
 
     void CompileProgram();
+    bool FinishProgram();
+    void GetUniformLocations();
 };
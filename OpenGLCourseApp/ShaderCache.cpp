@@ -0,0 +1,176 @@
+#include "ShaderCache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char* cacheDirectory = "ShaderCache";
+
+// written in front of every binary so we can tell junk from a real entry
+struct ShaderCacheHeader
+{
+  char magic[4];
+  uint32_t format;
+  uint32_t length;
+  uint32_t reserved;
+};
+
+static const char cacheMagic[4] = { 'S', 'P', 'B', '1' };
+
+// 64-bit FNV-1a, carried on from one string to the next
+static uint64_t HashString(uint64_t hash, const char* text, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    hash = (hash ^ (unsigned char)text[i]) * 1099511628211ull;
+  }
+
+  // mark the end of each string so "ab"+"c" and "a"+"bc" don't collide
+  return (hash ^ 0xff) * 1099511628211ull;
+}
+
+static uint64_t HashGLString(uint64_t hash, GLenum name)
+{
+  const char* value = (const char*)glGetString(name);
+  return value ? HashString(hash, value, strlen(value)) : HashString(hash, "", 0);
+}
+
+bool ShaderCache::IsAvailable()
+{
+  if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+  {
+    return false;
+  }
+
+  // some drivers expose the extension but won't hand out any binaries
+  GLint formatCount = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  return formatCount > 0;
+}
+
+uint64_t ShaderCache::MakeKey(const std::vector<std::string>& sources)
+{
+  uint64_t hash = 14695981039346656037ull;
+
+  hash = HashGLString(hash, GL_VENDOR);
+  hash = HashGLString(hash, GL_RENDERER);
+  hash = HashGLString(hash, GL_VERSION);
+
+  for (size_t i = 0; i < sources.size(); i++)
+  {
+    hash = HashString(hash, sources[i].data(), sources[i].size());
+  }
+
+  return hash;
+}
+
+bool ShaderCache::Load(GLuint program, uint64_t key)
+{
+  if (!IsAvailable())
+  {
+    return false;
+  }
+
+  std::string path = GetCachePath(key);
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+  {
+    return false;
+  }
+
+  ShaderCacheHeader header;
+  std::vector<char> binary;
+  bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+    memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 &&
+    header.length > 0;
+
+  if (valid)
+  {
+    binary.resize(header.length);
+    valid = fread(&binary[0], 1, header.length, file) == header.length;
+  }
+
+  fclose(file);
+
+  if (valid)
+  {
+    glProgramBinary(program, header.format, &binary[0], header.length);
+
+    GLint result = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    valid = result != 0;
+  }
+
+  // the driver can reject a binary for any reason it likes, so don't keep
+  // trying the same one every launch
+  if (!valid)
+  {
+    printf("Discarding stale shader cache entry %s\n", path.c_str());
+    remove(path.c_str());
+  }
+
+  return valid;
+}
+
+void ShaderCache::PrepareForSave(GLuint program)
+{
+  if (IsAvailable())
+  {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+}
+
+void ShaderCache::Save(GLuint program, uint64_t key)
+{
+  if (!IsAvailable())
+  {
+    return;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+  {
+    return;
+  }
+
+  ShaderCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, &binary[0]);
+  header.format = format;
+  header.length = length;
+
+  mkdir(cacheDirectory, 0755);
+
+  // write it next to the real entry first, so a crash halfway through
+  // never leaves a truncated binary behind
+  std::string path = GetCachePath(key);
+  std::string tempPath = path + ".tmp";
+
+  FILE* file = fopen(tempPath.c_str(), "wb");
+  if (!file)
+  {
+    printf("Failed to write shader cache entry %s\n", tempPath.c_str());
+    return;
+  }
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(&binary[0], 1, length, file) == (size_t)length;
+  fclose(file);
+
+  if (!written || rename(tempPath.c_str(), path.c_str()) != 0)
+  {
+    remove(tempPath.c_str());
+  }
+}
+
+std::string ShaderCache::GetCachePath(uint64_t key)
+{
+  char name[64] = { '\0' };
+  snprintf(name, sizeof(name), "%s/%016llx.bin", cacheDirectory, (unsigned long long)key);
+  return name;
+}
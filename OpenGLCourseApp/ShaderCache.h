@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Keeps linked program binaries on disk (in ShaderCache/) so the next launch
+// can skip compiling and linking altogether.
+//
+// Entries are keyed on a hash of every stage's final source and the driver's
+// vendor, renderer and version strings. A driver update or a shader edit just
+// makes a new key, and any binary the driver refuses gets thrown away so the
+// caller can fall back to compiling from source.
+class ShaderCache
+{
+  public:
+    // false when the driver has no binary formats to give us
+    static bool IsAvailable();
+
+    // the sources should already have their defines inserted
+    static uint64_t MakeKey(const std::vector<std::string>& sources);
+
+    // tries to load a cached binary into the program, true if it linked
+    static bool Load(GLuint program, uint64_t key);
+
+    // call before glLinkProgram on anything that'll be saved afterwards
+    static void PrepareForSave(GLuint program);
+    static void Save(GLuint program, uint64_t key);
+
+  private:
+    static std::string GetCachePath(uint64_t key);
+};
@@ -0,0 +1,250 @@
+#include "ShaderIncludes.h"
+
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "CommonValues.h"
+#include "FileSystem.h"
+
+std::unordered_map<std::string, std::string> ShaderIncludes::fileCache;
+
+static const char* commonValuesName = "CommonValues.glsl";
+
+static void AddValue(std::string& text, const char* name, int value)
+{
+  char line[128];
+  snprintf(line, sizeof(line), "#define %s %d\n", name, value);
+  text += line;
+}
+
+// the name and the value both come straight from CommonValues.h
+#define SHARE_VALUE(text, name) AddValue(text, #name, name)
+
+const std::string& ShaderIncludes::GetCommonValues()
+{
+  static std::string text;
+  if (!text.empty())
+  {
+    return text;
+  }
+
+  text = "// made from CommonValues.h by ShaderIncludes.cpp, add new values there\n";
+  SHARE_VALUE(text, MAX_POINT_LIGHTS);
+  SHARE_VALUE(text, MAX_SPOT_LIGHTS);
+  SHARE_VALUE(text, DIFFUSE_TEXTURE_UNIT);
+  SHARE_VALUE(text, MAX_TEXTURE_HANDLES);
+  SHARE_VALUE(text, MAX_TEXTURE_ARRAYS);
+  SHARE_VALUE(text, TEXTURE_ARRAY_UNIT);
+  SHARE_VALUE(text, TEXTURE_TABLE_BINDING);
+  SHARE_VALUE(text, MAX_DRAWS_PER_FRAME);
+  SHARE_VALUE(text, DRAW_RING_FRAMES);
+  SHARE_VALUE(text, DRAW_DATA_BINDING);
+  SHARE_VALUE(text, SHADOW_ATLAS_SIZE);
+  SHARE_VALUE(text, SHADOW_ATLAS_MIN_TILE);
+  SHARE_VALUE(text, SHADOW_ATLAS_UNIT);
+  SHARE_VALUE(text, SHADOW_FACE_BUDGET);
+  SHARE_VALUE(text, SHADOW_MAX_STALE_FRAMES);
+  SHARE_VALUE(text, VARIANCE_SHADOWS);
+  SHARE_VALUE(text, GBUFFER_TEXTURE_UNIT);
+
+  return text;
+}
+
+bool ShaderIncludes::IsGenerated(const std::string& fileLocation)
+{
+  return fileLocation == commonValuesName;
+}
+
+bool ShaderIncludes::ReadInclude(const std::string& fileLocation, bool fromDisk, std::string& contents)
+{
+  if (IsGenerated(fileLocation))
+  {
+    contents = GetCommonValues();
+    return true;
+  }
+
+  AssetFile file;
+  if (fromDisk && FileSystem::ReadLooseFile(fileLocation.c_str(), file))
+  {
+    contents = file.GetString();
+    fileCache[fileLocation] = contents;
+    return true;
+  }
+
+  std::unordered_map<std::string, std::string>::iterator cached = fileCache.find(fileLocation);
+  if (cached != fileCache.end())
+  {
+    contents = cached->second;
+    return true;
+  }
+
+  if (!FileSystem::ReadFile(fileLocation.c_str(), file))
+  {
+    return false;
+  }
+
+  contents = file.GetString();
+  fileCache[fileLocation] = contents;
+  return true;
+}
+
+std::string ShaderIncludes::Process(const std::string& fileLocation,
+    const std::string& source,
+    bool fromDisk,
+    std::vector<std::string>& files)
+{
+  files.clear();
+  files.push_back(fileLocation);
+
+  std::string output;
+  output.reserve(source.size());
+  Expand(source, 0, fileLocation, fromDisk, files, output);
+
+  return output;
+}
+
+void ShaderIncludes::Expand(const std::string& source,
+    int sourceIndex,
+    const std::string& fileLocation,
+    bool fromDisk,
+    std::vector<std::string>& files,
+    std::string& output)
+{
+  // includes are found next to the file that includes them
+  size_t slash = fileLocation.find_last_of("/\\");
+  std::string directory = slash == std::string::npos ? "" : fileLocation.substr(0, slash + 1);
+
+  char lineDirective[64];
+  int lineNumber = 0;
+
+  for (size_t start = 0; start < source.size(); )
+  {
+    size_t end = source.find('\n', start);
+    end = end == std::string::npos ? source.size() : end + 1;
+    lineNumber++;
+
+    size_t first = source.find_first_not_of(" \t", start);
+    bool isInclude = first < end && source.compare(first, 8, "#include") == 0;
+    bool isVersion = first < end && source.compare(first, 8, "#version") == 0;
+
+    if (!isInclude)
+    {
+      output.append(source, start, end - start);
+      if (output.empty() || output[output.size() - 1] != '\n')
+      {
+        output += '\n';
+      }
+
+      // defines get inserted after #version, so the numbering has to be
+      // put back right after it
+      if (isVersion)
+      {
+        snprintf(lineDirective, sizeof(lineDirective), "#line %d %d\n", lineNumber + 1, sourceIndex);
+        output += lineDirective;
+      }
+
+      start = end;
+      continue;
+    }
+
+    std::string line = source.substr(start, end - start);
+    size_t open = line.find('"');
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    start = end;
+
+    // the include line itself turns into a blank one, keeping the count
+    if (close == std::string::npos)
+    {
+      printf("%s(%d): bad #include, expected a \"file\"\n", fileLocation.c_str(), lineNumber);
+      output += '\n';
+      continue;
+    }
+
+    std::string name = line.substr(open + 1, close - open - 1);
+    std::string includeLocation = IsGenerated(name) ? name : directory + name;
+
+    // once per stage, a second include of the same file does nothing
+    if (std::find(files.begin(), files.end(), includeLocation) != files.end())
+    {
+      output += '\n';
+      continue;
+    }
+
+    std::string contents;
+    if (!ReadInclude(includeLocation, fromDisk, contents))
+    {
+      printf("%s(%d): can't find %s to include\n",
+          fileLocation.c_str(), lineNumber, includeLocation.c_str());
+      output += '\n';
+      continue;
+    }
+
+    files.push_back(includeLocation);
+    snprintf(lineDirective, sizeof(lineDirective), "#line 1 %d\n", (int)files.size() - 1);
+    output += lineDirective;
+
+    Expand(contents, (int)files.size() - 1, includeLocation, fromDisk, files, output);
+
+    snprintf(lineDirective, sizeof(lineDirective), "#line %d %d\n", lineNumber + 1, sourceIndex);
+    output += lineDirective;
+  }
+}
+
+std::string ShaderIncludes::RemapLog(const std::string& log, const std::vector<std::string>& files)
+{
+  std::string output;
+
+  for (size_t start = 0; start < log.size(); )
+  {
+    size_t end = log.find('\n', start);
+    end = end == std::string::npos ? log.size() : end + 1;
+    std::string line = log.substr(start, end - start);
+    start = end;
+
+    // Every driver words it differently, but they all lead with the source
+    // string number followed by the line:
+    //   0(12) : error C1008: ...           (nvidia)
+    //   0:12(3): error: ...                (mesa)
+    //   ERROR: 0:12: ...                   (amd, intel)
+    size_t number = 0;
+    if (line.compare(0, 7, "ERROR: ") == 0)
+    {
+      number = 7;
+    }
+    else if (line.compare(0, 9, "WARNING: ") == 0)
+    {
+      number = 9;
+    }
+
+    size_t digitsEnd = number;
+    while (digitsEnd < line.size() && isdigit((unsigned char)line[digitsEnd]))
+    {
+      digitsEnd++;
+    }
+
+    bool hasLine = digitsEnd > number && digitsEnd + 1 < line.size() &&
+      (line[digitsEnd] == '(' || line[digitsEnd] == ':') &&
+      isdigit((unsigned char)line[digitsEnd + 1]);
+
+    if (hasLine)
+    {
+      size_t index = strtoul(line.c_str() + number, nullptr, 10);
+      if (index < files.size())
+      {
+        line.replace(number, digitsEnd - number, files[index]);
+      }
+    }
+
+    output += line;
+  }
+
+  return output;
+}
+
+void ShaderIncludes::ClearIncludes()
+{
+  fileCache.clear();
+}
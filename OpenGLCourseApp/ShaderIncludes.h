@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// #include "file" for GLSL, which has no preprocessor support for it.
+//
+// Paths are relative to the file doing the including. Every file is pasted
+// in once per stage no matter how many times it's included, so shared
+// files don't need guards of their own. #line directives are put around
+// each one, so the driver reports errors against the right line, with the
+// file's index in the list as its source string number.
+//
+// "CommonValues.glsl" isn't a real file, it's made from the constants in
+// CommonValues.h so the shaders and the C++ can't disagree on them.
+class ShaderIncludes
+{
+  public:
+    // source is the contents of fileLocation. files gets every file that
+    // went into the result, index 0 being fileLocation itself.
+    static std::string Process(const std::string& fileLocation,
+        const std::string& source,
+        bool fromDisk,
+        std::vector<std::string>& files);
+
+    // swaps the source string numbers in a compile log for file names
+    static std::string RemapLog(const std::string& log, const std::vector<std::string>& files);
+
+    // the generated CommonValues.glsl
+    static const std::string& GetCommonValues();
+
+    static bool IsGenerated(const std::string& fileLocation);
+
+    static void ClearIncludes();
+
+  private:
+    // Shared files are read once and reused by every shader and variant
+    // that includes them. Reading from disk (a hot reload) refreshes them.
+    static std::unordered_map<std::string, std::string> fileCache;
+
+    static bool ReadInclude(const std::string& fileLocation, bool fromDisk, std::string& contents);
+
+    static void Expand(const std::string& source,
+        int sourceIndex,
+        const std::string& fileLocation,
+        bool fromDisk,
+        std::vector<std::string>& files,
+        std::string& output);
+};
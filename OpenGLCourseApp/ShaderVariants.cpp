@@ -0,0 +1,84 @@
+#include "ShaderVariants.h"
+
+#include <stdio.h>
+
+ShaderKey::ShaderKey()
+{
+  pointLightCount = 0;
+  spotLightCount = 0;
+  shadows = true;
+  pcfRadius = 1;
+}
+
+ShaderKey::ShaderKey(int pointLights, int spotLights, bool shadowsOn, int pcf)
+{
+  pointLightCount = pointLights;
+  spotLightCount = spotLights;
+  shadows = shadowsOn;
+  pcfRadius = pcf;
+}
+
+std::string ShaderKey::GetDefines() const
+{
+  char defines[256];
+  snprintf(defines, sizeof(defines),
+      "#define POINT_LIGHT_COUNT %d\n"
+      "#define SPOT_LIGHT_COUNT %d\n"
+      "#define SHADOWS %d\n"
+      "#define PCF_RADIUS %d\n",
+      pointLightCount,
+      spotLightCount,
+      shadows ? 1 : 0,
+      pcfRadius);
+
+  return defines;
+}
+
+bool ShaderKey::operator<(const ShaderKey& other) const
+{
+  if (pointLightCount != other.pointLightCount) return pointLightCount < other.pointLightCount;
+  if (spotLightCount != other.spotLightCount) return spotLightCount < other.spotLightCount;
+  if (shadows != other.shadows) return shadows < other.shadows;
+  return pcfRadius < other.pcfRadius;
+}
+
+ShaderVariants::ShaderVariants(){}
+
+void ShaderVariants::SetFiles(const char* vertexLoc, const char* fragmentLoc)
+{
+  ClearVariants();
+
+  vertexLocation = vertexLoc;
+  fragmentLocation = fragmentLoc;
+}
+
+Shader* ShaderVariants::Get(const ShaderKey& key)
+{
+  std::map<ShaderKey, Shader*>::iterator found = variants.find(key);
+  if (found != variants.end())
+  {
+    return found->second;
+  }
+
+  Shader* shader = new Shader();
+  shader->SetDefines(baseDefines + key.GetDefines());
+  shader->CreateFromFiles(vertexLocation.c_str(), fragmentLocation.c_str());
+
+  variants[key] = shader;
+  return shader;
+}
+
+void ShaderVariants::ClearVariants()
+{
+  for (std::map<ShaderKey, Shader*>::iterator it = variants.begin(); it != variants.end(); ++it)
+  {
+    delete it->second;
+  }
+
+  variants.clear();
+}
+
+ShaderVariants::~ShaderVariants()
+{
+  ClearVariants();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "Shader.h"
+
+// Everything about the scene that a lighting shader variant gets built for.
+// Each value becomes a #define, so loops over the lights have a fixed trip
+// count and anything switched off is stripped out by the compiler.
+struct ShaderKey
+{
+  int pointLightCount;
+  int spotLightCount;
+  bool shadows;
+  // pcf kernel is (2 * radius + 1)^2 taps, 0 samples the shadow map once
+  int pcfRadius;
+
+  ShaderKey();
+  ShaderKey(int pointLights, int spotLights, bool shadowsOn, int pcf);
+
+  std::string GetDefines() const;
+
+  bool operator<(const ShaderKey& other) const;
+};
+
+// All the specialised builds of one pair of shader files, made on demand
+// and kept around for as long as the set lives.
+class ShaderVariants
+{
+  public:
+    ShaderVariants();
+
+    void SetFiles(const char* vertexLocation, const char* fragmentLocation);
+
+    // defines shared by every variant (the texture table mode etc.)
+    void SetBaseDefines(const std::string& defineBlock) { baseDefines = defineBlock; }
+
+    // the variant for this key, it starts building the first time it's asked
+    // for so check IsReady() before using it if you don't want to wait
+    Shader* Get(const ShaderKey& key);
+
+    void ClearVariants();
+
+    ~ShaderVariants();
+
+  private:
+    std::string vertexLocation;
+    std::string fragmentLocation;
+    std::string baseDefines;
+
+    std::map<ShaderKey, Shader*> variants;
+
+    // holds raw pointers to programs, so no copying
+    ShaderVariants(const ShaderVariants&);
+    ShaderVariants& operator=(const ShaderVariants&);
+};
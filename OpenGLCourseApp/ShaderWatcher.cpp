@@ -0,0 +1,146 @@
+#include "ShaderWatcher.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <algorithm>
+
+#include "Shader.h"
+
+ShaderWatcher::WatchState* ShaderWatcher::state = nullptr;
+
+bool ShaderWatcher::Init()
+{
+  if (state)
+  {
+    return true;
+  }
+
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0)
+  {
+    printf("Shader hot reloading is off, inotify isn't available\n");
+    return false;
+  }
+
+  state = new WatchState();
+  state->inotifyFD = fd;
+  return true;
+}
+
+void ShaderWatcher::Watch(Shader* shader, const std::vector<std::string>& files)
+{
+  if (!state)
+  {
+    return;
+  }
+
+  Unwatch(shader);
+
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    // Watch the directory rather than the file. Most editors save by writing
+    // a new file and renaming it over the old one, which would leave a
+    // watch on the file itself pointing at nothing.
+    size_t slash = files[i].find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "." : files[i].substr(0, slash);
+    std::string fileName = slash == std::string::npos ? files[i] : files[i].substr(slash + 1);
+
+    // adding the same directory twice just hands back the same watch
+    int wd = inotify_add_watch(state->inotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+    {
+      // probably only in the asset pack, nothing on disk to watch
+      continue;
+    }
+
+    WatchedFile watched;
+    watched.shader = shader;
+    watched.directoryWatch = wd;
+    watched.fileName = fileName;
+    state->files.push_back(watched);
+  }
+}
+
+void ShaderWatcher::Unwatch(Shader* shader)
+{
+  if (!state)
+  {
+    return;
+  }
+
+  // the directory watches stay, other shaders are probably using them too
+  for (size_t i = 0; i < state->files.size(); )
+  {
+    if (state->files[i].shader == shader)
+    {
+      state->files.erase(state->files.begin() + i);
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
+void ShaderWatcher::Poll()
+{
+  if (!state)
+  {
+    return;
+  }
+
+  // a single save can show up as several events, so gather every shader
+  // that needs rebuilding first and then do each one once
+  std::vector<Shader*> changed;
+
+  char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  for (;;)
+  {
+    ssize_t length = read(state->inotifyFD, buffer, sizeof(buffer));
+    if (length <= 0)
+    {
+      // EAGAIN just means there's nothing left to read
+      break;
+    }
+
+    for (char* ptr = buffer; ptr < buffer + length; )
+    {
+      const struct inotify_event* event = (const struct inotify_event*)ptr;
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      if (event->len == 0)
+      {
+        continue;
+      }
+
+      for (size_t i = 0; i < state->files.size(); i++)
+      {
+        const WatchedFile& watched = state->files[i];
+        if (watched.directoryWatch == event->wd && watched.fileName == event->name &&
+            std::find(changed.begin(), changed.end(), watched.shader) == changed.end())
+        {
+          changed.push_back(watched.shader);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < changed.size(); i++)
+  {
+    changed[i]->Reload();
+  }
+}
+
+void ShaderWatcher::Shutdown()
+{
+  if (!state)
+  {
+    return;
+  }
+
+  close(state->inotifyFD);
+  delete state;
+  state = nullptr;
+}
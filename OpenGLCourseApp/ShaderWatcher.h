@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Watches the source files of every shader built with CreateFromFiles and
+// rebuilds the shader when one of them is saved. Uses inotify, so it only
+// does anything on Linux.
+//
+// Poll() has to be called from the thread that owns the GL context, once a
+// frame is plenty. A shader that fails to build keeps its old program.
+class ShaderWatcher
+{
+  public:
+    static bool Init();
+
+    static void Watch(Shader* shader, const std::vector<std::string>& files);
+    static void Unwatch(Shader* shader);
+
+    // reloads everything that changed since the last call, never blocks
+    // waiting for changes
+    static void Poll();
+
+    static void Shutdown();
+
+  private:
+    struct WatchedFile
+    {
+      Shader* shader;
+      int directoryWatch;
+      std::string fileName;
+    };
+
+    struct WatchState
+    {
+      int inotifyFD;
+      std::vector<WatchedFile> files;
+    };
+
+    // Kept on the heap and never freed by a static destructor, shaders are
+    // globals and may unwatch themselves after this file's statics are gone
+    static WatchState* state;
+};
@@ -0,0 +1,14 @@
+#version 330
+
+layout (location = 0) in vec3 pos;
+
+#include "draw_data.glsl"
+
+// one face of a point light, or a spot light's view down its cone
+uniform mat4 lightMatrix;
+
+void main()
+{
+  mat4 model = draws[drawID].model;
+  gl_Position = lightMatrix * model * vec4(pos, 1.0f);
+}
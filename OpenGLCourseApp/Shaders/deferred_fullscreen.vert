@@ -0,0 +1,9 @@
+#version 330
+
+// No vertex buffer, just one triangle big enough to cover the whole screen:
+// (-1,-1), (3,-1) and (-1,3).
+void main()
+{
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
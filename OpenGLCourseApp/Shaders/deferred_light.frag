@@ -0,0 +1,73 @@
+#version 330
+
+// One light per draw, picked with LIGHT_DIRECTIONAL, LIGHT_POINT or
+// LIGHT_SPOT. The maths is the same as shader.frag, the surface just comes
+// out of the G-buffer instead of the vertex shader.
+
+out vec4 color;
+
+#include "lights.glsl"
+
+// named like shader.frag so Shader can set them the same way, only ever
+// the first one of each gets used
+uniform DirectionalLight directionalLight;
+uniform PointLight pointLights[1];
+uniform SpotLight spotLights[1];
+
+uniform DirectionalShadowSampler directionalShadowMap;
+uniform mat4 directionalLightTransform;
+uniform sampler2DShadow shadowAtlas;
+uniform OmniShadowMap omniShadowMaps[1];
+
+// see GBuffer.h
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gMaterial;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+uniform vec3 eyePosition;
+
+// filled in from the G-buffer by main()
+vec3 FragPos;
+vec3 Normal;
+vec2 MaterialParams;
+
+#include "lighting.glsl"
+
+void main()
+{
+  ivec2 texel = ivec2(gl_FragCoord.xy);
+  float depth = texelFetch(gDepth, texel, 0).r;
+
+  // nothing was drawn here, leave the background alone
+  if (depth == 1.0f)
+  {
+    discard;
+  }
+
+  // back from window coordinates to world space
+  vec4 ndc = vec4(gl_FragCoord.xy / screenSize, depth, 1.0f) * 2.0f - 1.0f;
+  vec4 worldPos = inverseViewProjection * ndc;
+  FragPos = worldPos.xyz / worldPos.w;
+
+  Normal = texelFetch(gNormal, texel, 0).xyz;
+  MaterialParams = texelFetch(gMaterial, texel, 0).xy;
+
+#if defined(LIGHT_POINT)
+  vec4 lightColor = CalcPointLight(pointLights[0], 0);
+#elif defined(LIGHT_SPOT)
+  vec4 lightColor = CalcSpotLight(spotLights[0], 0);
+#else
+  vec4 lightSpacePos = directionalLightTransform * vec4(FragPos, 1.0f);
+  float shadowFactor = CalcDirectionalShadowFactor(directionalLight, lightSpacePos);
+  vec4 lightColor = CalcLightByDirection(
+      directionalLight.base,
+      directionalLight.direction,
+      shadowFactor);
+#endif
+
+  // added on top of the other lights by the blend
+  color = texelFetch(gAlbedo, texel, 0) * lightColor;
+}
@@ -0,0 +1,13 @@
+#version 330
+
+layout (location = 0) in vec3 pos;
+
+uniform mat4 projection;
+uniform mat4 view;
+// places the unit sphere or cone around the light, see DeferredRenderer.cpp
+uniform mat4 lightModel;
+
+void main()
+{
+  gl_Position = projection * view * lightModel * vec4(pos, 1.0f);
+}
@@ -0,0 +1,19 @@
+#version 330
+
+layout (location = 0) in vec3 pos;
+
+#include "draw_data.glsl"
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// The lighting pass tests against this depth with GL_EQUAL, so the position
+// has to come out bit for bit the same as in shader.vert. Same maths in the
+// same order, and invariant so the compiler can't rearrange it either.
+invariant gl_Position;
+
+void main()
+{
+  mat4 model = draws[drawID].model;
+  gl_Position = projection * view * model * vec4(pos, 1.0f);
+}
@@ -2,10 +2,12 @@
 
 layout (location = 0) in vec3 pos;
 
-uniform mat4 model;
+#include "draw_data.glsl"
+
 uniform mat4 directionalLightTransform;
 
 void main()
 {
+  mat4 model = draws[drawID].model;
   gl_Position = directionalLightTransform * model * vec4(pos, 1.0f);
 }
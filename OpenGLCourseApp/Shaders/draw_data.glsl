@@ -0,0 +1,16 @@
+// per-draw data for the whole frame (see DrawData.h), drawID picks ours
+#include "CommonValues.glsl"
+
+struct DrawData
+{
+  mat4 model;
+  mat3 normal;   // worked out on the CPU, see DrawData.cpp
+  vec4 material; // x = specular intensity, y = shininess
+};
+
+layout(std140) uniform DrawBlock
+{
+  DrawData draws[MAX_DRAWS_PER_FRAME];
+};
+
+uniform int drawID;
@@ -0,0 +1,23 @@
+#version 330
+
+#ifdef TEXTURE_TABLE_BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+in vec2 TexCoord;
+in vec3 Normal;
+flat in vec2 MaterialParams;
+
+// one output per G-buffer attachment, see GBuffer.h
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 normal;
+layout (location = 2) out vec2 material;
+
+#include "texture_table.glsl"
+
+void main()
+{
+  albedo = SampleDiffuse(TexCoord);
+  normal = vec4(normalize(Normal), 0.0f);
+  material = MaterialParams;
+}
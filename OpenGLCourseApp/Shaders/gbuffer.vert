@@ -0,0 +1,25 @@
+#version 330
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 tex;
+layout (location = 2) in vec3 norm;
+
+out vec2 TexCoord;
+out vec3 Normal;
+flat out vec2 MaterialParams;
+
+#include "draw_data.glsl"
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+  mat4 model = draws[drawID].model;
+  MaterialParams = draws[drawID].material.xy;
+
+  gl_Position = projection * view * model * vec4(pos, 1.0f);
+
+  TexCoord = tex;
+  Normal = draws[drawID].normal * norm;
+}
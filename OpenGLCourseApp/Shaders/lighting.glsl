@@ -0,0 +1,253 @@
+// The lighting maths shared by the forward shader and the deferred lights.
+//
+// Before including this the shader has to declare the surface being lit,
+// however it gets it:
+//   vec3 FragPos, vec3 Normal, vec2 MaterialParams (specular intensity, shininess)
+// and the uniforms:
+//   vec3 eyePosition, DirectionalShadowSampler directionalShadowMap,
+//   sampler2DShadow shadowAtlas, OmniShadowMap omniShadowMaps[]
+#include "lights.glsl"
+
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+
+// 1 is a 3x3 kernel, 0 is a single sample
+#ifndef PCF_RADIUS
+#define PCF_RADIUS 1
+#endif
+
+float CalcDirectionalShadowFactor(DirectionalLight light, vec4 lightSpacePos)
+{
+#if !SHADOWS
+  return 0.0f;
+#else
+  vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
+  projCoords = (projCoords * 0.5) + 0.5; // keep values between 0 and 1
+ 
+  float current = projCoords.z;
+
+  // if beyond far plane, don't place shadow
+  if (projCoords.z > 1.0f)
+  {
+    return 0.0f;
+  }
+
+#if VARIANCE_SHADOWS
+  // the map's already blurred, so this one lookup is the average depth
+  // (and depth squared) of everything around it
+  vec2 moments = texture(directionalShadowMap, projCoords.xy).rg;
+  if (current <= moments.x)
+  {
+    return 0.0f;
+  }
+
+  // Chebyshev's inequality gives the most of the area that could be
+  // farther away than us, i.e. lit
+  float variance = max(moments.y - moments.x * moments.x, 0.00002f);
+  float d = current - moments.x;
+  float lit = variance / (variance + d * d);
+
+  // the bottom of that range lets light bleed through where shadows
+  // overlap, throw it away
+  lit = clamp((lit - 0.2f) / 0.8f, 0.0f, 1.0f);
+
+  return 1.0f - lit;
+#else
+  vec3 normal = normalize(Normal);
+  vec3 lightDir = normalize(light.direction);
+  // prevent banding from shadows
+  float bias = max(0.05f * (1.0f - dot(normal, lightDir)), 0.005f);
+
+  // The sampler does the compare, and with linear filtering it blends
+  // the results of the 4 nearest texels, so every tap is already a 2x2 PCF
+  float lit = 0.0f;
+  vec2 texelSize = 1.0f / textureSize(directionalShadowMap, 0);
+  for (int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x)
+  {
+    for (int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y)
+    {
+      lit += texture(directionalShadowMap,
+          vec3(projCoords.xy + vec2(x, y) * texelSize, current - bias));
+    }
+  }
+
+  lit /= float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
+
+  return 1.0f - lit;
+#endif
+#endif
+}
+
+// the cube faces in the same order, and with the same up vectors, as
+// PointLight::CalculateLightTransform
+const vec3 faceForward[6] = vec3[6](
+    vec3(1.0f, 0.0f, 0.0f), vec3(-1.0f, 0.0f, 0.0f),
+    vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f),
+    vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+
+const vec3 faceUp[6] = vec3[6](
+    vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f),
+    vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f),
+    vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f));
+
+// How lit uv is in the tile, compared against depth by the sampler. 1 is
+// fully lit, in between along a shadow's edge.
+float SampleShadowAtlas(vec4 tile, vec2 uv, float depth)
+{
+  // stay half a texel inside the tile so filtering doesn't reach the next
+  vec2 halfTexel = 0.5f / vec2(textureSize(shadowAtlas, 0));
+  vec2 coord = clamp(tile.xy + uv * tile.zw, tile.xy + halfTexel, tile.xy + tile.zw - halfTexel);
+
+  return texture(shadowAtlas, vec3(coord, depth));
+}
+
+float CalcOmniShadowFactor(PointLight light, int shadowIndex)
+{
+#if !SHADOWS
+  return 0.0f;
+#else
+  vec3 fragToLight = FragPos - light.position;
+
+  // the face is whichever axis the direction is longest along, same as
+  // a cube map would pick
+  vec3 axis = abs(fragToLight);
+  int face = axis.x >= axis.y && axis.x >= axis.z ? (fragToLight.x > 0.0f ? 0 : 1) :
+    (axis.y >= axis.z ? (fragToLight.y > 0.0f ? 2 : 3) : (fragToLight.z > 0.0f ? 4 : 5));
+
+  vec4 tile = omniShadowMaps[shadowIndex].tiles[face];
+  if (tile.z == 0.0f)
+  {
+    return 0.0f;
+  }
+
+  // what the face's lookAt and 90 degree perspective would do to it
+  vec3 forward = faceForward[face];
+  vec3 right = cross(forward, faceUp[face]);
+  vec3 up = cross(right, forward);
+  float distance = dot(fragToLight, forward);
+  vec2 uv = vec2(dot(fragToLight, right), dot(fragToLight, up)) / distance;
+
+  // pulled towards the light a little, which leaves uv where it is
+  float bias = 0.05f;
+  distance *= 1.0f - bias / length(fragToLight);
+
+  // the depth the perspective would have written for it
+  float nearPlane = omniShadowMaps[shadowIndex].nearPlane;
+  float farPlane = omniShadowMaps[shadowIndex].farPlane;
+  float ndcDepth = (farPlane + nearPlane) / (farPlane - nearPlane) -
+    2.0f * farPlane * nearPlane / ((farPlane - nearPlane) * distance);
+
+  return 1.0f - SampleShadowAtlas(tile, uv * 0.5f + 0.5f, ndcDepth * 0.5f + 0.5f);
+#endif
+}
+
+float CalcSpotShadowFactor(SpotLight light, int shadowIndex)
+{
+#if !SHADOWS
+  return 0.0f;
+#else
+  vec4 tile = omniShadowMaps[shadowIndex].tiles[0];
+  if (tile.z == 0.0f)
+  {
+    return 0.0f;
+  }
+
+  // pulled towards the light a little, which leaves it at the same place
+  // in the map and only changes the depth
+  float bias = 0.05f;
+  vec3 biasedPos = FragPos + normalize(light.base.position - FragPos) * bias;
+
+  vec4 lightSpacePos = omniShadowMaps[shadowIndex].lightMatrix * vec4(biasedPos, 1.0f);
+  vec2 uv = (lightSpacePos.xy / lightSpacePos.w) * 0.5f + 0.5f;
+
+  // outside the cone, it isn't lit anyway
+  if (lightSpacePos.w <= 0.0f || any(lessThan(uv, vec2(0.0f))) || any(greaterThan(uv, vec2(1.0f))))
+  {
+    return 0.0f;
+  }
+
+  // drawn with the hardware's own depth, so it's compared the same way
+  // the directional light is
+  float current = (lightSpacePos.z / lightSpacePos.w) * 0.5f + 0.5f;
+
+  // a texel of the atlas, in the tile's 0 to 1 range
+  vec2 texelSize = 1.0f / (tile.zw * vec2(textureSize(shadowAtlas, 0)));
+
+  float lit = 0.0f;
+  for (int x = -PCF_RADIUS; x <= PCF_RADIUS; ++x)
+  {
+    for (int y = -PCF_RADIUS; y <= PCF_RADIUS; ++y)
+    {
+      lit += SampleShadowAtlas(tile, uv + vec2(x, y) * texelSize, current);
+    }
+  }
+
+  return 1.0f - lit / float((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
+#endif
+}
+
+vec4 CalcLightByDirection(Light light, vec3 direction, float shadowFactor)
+{
+  // calculate ambient color
+  vec4 ambientColor = vec4(light.color, 1.0f) * light.ambientIntensity;
+
+  // calculate diffuse color
+  float diffuseFactor = max(dot(normalize(Normal), normalize(direction)), 0.0f);
+  vec4 diffuseColor = vec4(light.color, 1.0f) * light.diffuseIntensity * diffuseFactor;
+
+  // calculate specular
+  vec4 specularColor = vec4(0, 0, 0, 0);
+
+  // Remember, a specular light should only show up if there is a diffuse factor!
+  // If no light hits the object then there shouldn't be a specular.
+  if (diffuseFactor > 0.0f)
+  {
+    vec3 fragToEye = normalize(eyePosition - FragPos);
+    vec3 reflectedVertex = normalize(reflect(direction, normalize(Normal)));
+
+    float specularFactor = dot(fragToEye, reflectedVertex);
+    if (specularFactor > 0.0f)
+    {
+      specularFactor = pow(specularFactor, MaterialParams.y);
+      specularColor = vec4(light.color * MaterialParams.x * specularFactor, 1.0f);
+    }
+  }
+
+  return ambientColor + (1.0f - shadowFactor) * (diffuseColor + specularColor);
+}
+
+vec4 CalcAttenuatedLight(PointLight pLight, float shadowFactor)
+{
+  vec3 direction = FragPos - pLight.position;
+  float distance = length(direction);
+  direction = normalize(direction);
+
+  vec4 color = CalcLightByDirection(pLight.base, direction, shadowFactor);
+  float attenuation = pLight.exponent * distance * distance +
+    pLight.linear * distance +
+    pLight.constant;
+
+  return color / attenuation;
+}
+
+vec4 CalcPointLight(PointLight pLight, int shadowIndex)
+{
+  return CalcAttenuatedLight(pLight, CalcOmniShadowFactor(pLight, shadowIndex));
+}
+
+vec4 CalcSpotLight(SpotLight sLight, int shadowIndex)
+{
+  vec3 rayDirection = normalize(FragPos - sLight.base.position);
+  float slFactor = dot(rayDirection, sLight.direction);
+
+  // check if fragment is within the cone of the spot light
+  if(slFactor > sLight.edge)
+  {
+    float shadowFactor = CalcSpotShadowFactor(sLight, shadowIndex);
+    vec4 color = CalcAttenuatedLight(sLight.base, shadowFactor);
+    return color * (1.0f - (1.0f - slFactor) / (1.0f - sLight.edge));
+  }
+
+  return vec4(0, 0, 0, 0);
+}
@@ -0,0 +1,53 @@
+// the light types, laid out to match what Shader sets
+#include "CommonValues.glsl"
+
+struct Light
+{
+  vec3 color;
+  float ambientIntensity;
+  float diffuseIntensity;
+};
+
+struct DirectionalLight
+{
+  Light base;
+  vec3 direction;
+};
+
+struct PointLight
+{
+  Light base;
+  vec3 position;
+  float constant;
+  float linear;
+  float exponent;
+};
+
+struct SpotLight
+{
+  PointLight base;
+  vec3 direction;
+  float edge;
+};
+
+// Where a point or spot light's shadows are in the shadow atlas. Tiles
+// are xy = corner and zw = size in texture coordinates, with no size when
+// the light didn't get any room this frame. A point light has one tile per
+// cube face, each holding the depth from a 90 degree perspective between
+// nearPlane and farPlane. A spot light only uses the first, holding the
+// depth from lightMatrix.
+struct OmniShadowMap
+{
+  vec4 tiles[6];
+  mat4 lightMatrix;
+  float nearPlane;
+  float farPlane;
+};
+
+// Shadow maps that hold plain depth are compared by the sampler itself.
+// Variance ones hold moments, so they're read like any other texture.
+#if VARIANCE_SHADOWS
+#define DirectionalShadowSampler sampler2D
+#else
+#define DirectionalShadowSampler sampler2DShadow
+#endif
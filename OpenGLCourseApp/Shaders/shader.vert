@@ -9,14 +9,22 @@ out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
 out vec4 DirectionalLightSpacePos;
+flat out vec2 MaterialParams;
+
+#include "draw_data.glsl"
 
-uniform mat4 model;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 directionalLightTransform;
 
+// has to match depth_prepass.vert exactly for the GL_EQUAL depth test
+invariant gl_Position;
+
 void main()
 {
+  mat4 model = draws[drawID].model;
+  MaterialParams = draws[drawID].material.xy;
+
   gl_Position = projection * view * model * vec4(pos, 1.0f);
   DirectionalLightSpacePos = directionalLightTransform * model * vec4(pos, 1.0f);
 
@@ -24,13 +32,11 @@ void main()
 
   TexCoord = tex;
 
-  // Remember, the last column and row of our model deals with
-  // rotation and scale. We don't need them! So, mat3().
-  // The inverse and transpose also helps non-uniform scaling.
-  //
-  // The reason we need to do all this then multiply by norm is
-  // so we can account for scaling and rotation!
-  Normal = mat3(transpose(inverse(model))) * norm;
+  // The normal matrix (the inverse transpose of the model's 3x3) accounts
+  // for rotation and non-uniform scaling. It's the same for every vertex of
+  // the object, so it gets worked out once on the CPU and not in here.
+  // It isn't normalized, the fragment shader does that.
+  Normal = draws[drawID].normal * norm;
 
   // Firstly, we want the position of the fragment within the world.
   // As such, we don't multiply by the projection and view matrices.
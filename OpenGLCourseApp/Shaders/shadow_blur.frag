@@ -0,0 +1,26 @@
+#version 330
+
+// One direction of a separable 9 tap gaussian. Linear filtering blends two
+// texels per lookup, so it's 5 lookups with the offsets and weights worked
+// out to land between each pair.
+
+out vec2 color;
+
+uniform sampler2D moments;
+// one texel along the direction being blurred
+uniform vec2 blurStep;
+
+const float offsets[3] = float[3](0.0f, 1.3846153846f, 3.2307692308f);
+const float weights[3] = float[3](0.2270270270f, 0.3162162162f, 0.0702702703f);
+
+void main()
+{
+  vec2 uv = gl_FragCoord.xy / vec2(textureSize(moments, 0));
+
+  color = texture(moments, uv).rg * weights[0];
+  for (int i = 1; i < 3; i++)
+  {
+    color += texture(moments, uv + blurStep * offsets[i]).rg * weights[i];
+    color += texture(moments, uv - blurStep * offsets[i]).rg * weights[i];
+  }
+}
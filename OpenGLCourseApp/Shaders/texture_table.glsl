@@ -0,0 +1,43 @@
+// SampleDiffuse(uv) reads the current object's diffuse texture, whichever
+// way TextureTable is set up. The bindless extension has to be enabled by
+// the including file, before anything else.
+#include "CommonValues.glsl"
+
+#if defined(TEXTURE_TABLE_BINDLESS) || defined(TEXTURE_TABLE_ARRAYS)
+// every texture in the scene. xy is either a bindless handle, or the
+// array and layer to sample from (see TextureTable.h)
+layout(std140) uniform TextureTable
+{
+  uvec4 textureEntries[MAX_TEXTURE_HANDLES];
+};
+
+uniform int textureIndex;
+#else
+uniform sampler2D theTexture;
+#endif
+
+#ifdef TEXTURE_TABLE_ARRAYS
+uniform sampler2DArray textureArrays[MAX_TEXTURE_ARRAYS];
+#endif
+
+vec4 SampleDiffuse(vec2 uv)
+{
+#if defined(TEXTURE_TABLE_BINDLESS)
+  return texture(sampler2D(textureEntries[textureIndex].xy), uv);
+#elif defined(TEXTURE_TABLE_ARRAYS)
+  uvec4 entry = textureEntries[textureIndex];
+  vec3 coord = vec3(uv, float(entry.y));
+
+  // GLSL 330 only allows indexing sampler arrays with constants
+  switch (entry.x)
+  {
+    case 0u: return texture(textureArrays[0], coord);
+    case 1u: return texture(textureArrays[1], coord);
+    case 2u: return texture(textureArrays[2], coord);
+    case 3u: return texture(textureArrays[3], coord);
+    default: return texture(textureArrays[4], coord);
+  }
+#else
+  return texture(theTexture, uv);
+#endif
+}
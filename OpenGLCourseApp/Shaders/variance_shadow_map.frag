@@ -0,0 +1,16 @@
+#version 330
+
+// depth and depth squared, see VarianceShadowMap.h
+out vec2 moments;
+
+void main()
+{
+  float depth = gl_FragCoord.z;
+
+  // how much the depth changes across the texel counts towards the
+  // variance too, it keeps sloped surfaces from shadowing themselves
+  float dx = dFdx(depth);
+  float dy = dFdy(depth);
+
+  moments = vec2(depth, depth * depth + 0.25f * (dx * dx + dy * dy));
+}
@@ -0,0 +1,214 @@
+#include "ShadowAtlas.h"
+
+ShadowAtlas::ShadowAtlas()
+{
+  FBO = 0;
+  shadowMap = 0;
+  atlasSize = 0;
+}
+
+bool ShadowAtlas::Init(GLuint size, GLenum depthFormat)
+{
+  ClearAtlas();
+
+  atlasSize = size;
+
+  glGenFramebuffers(1, &FBO);
+
+  glGenTextures(1, &shadowMap);
+  glBindTexture(GL_TEXTURE_2D, shadowMap);
+  ShadowMap::AllocateStorage(depthFormat, atlasSize, atlasSize);
+
+  // the shaders keep their lookups half a texel inside each tile, so
+  // filtering never mixes in a neighbour
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // compared by the sampler, like the directional shadow map
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
+
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    printf("Shadow Atlas Framebuffer Error: %i\n", status);
+    return false;
+  }
+
+  // unbind framebuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  Clear();
+  return true;
+}
+
+void ShadowAtlas::Clear()
+{
+  Square whole = { 0, 0, (GLsizei)atlasSize };
+
+  freeSquares.clear();
+  freeSquares.push_back(whole);
+}
+
+bool ShadowAtlas::Take(GLsizei size, Square& square)
+{
+  // the smallest square it fits in, so big ones stay whole for longer
+  int best = -1;
+  for (size_t i = 0; i < freeSquares.size(); i++)
+  {
+    if (freeSquares[i].size >= size &&
+        (best < 0 || freeSquares[i].size < freeSquares[best].size))
+    {
+      best = i;
+    }
+  }
+
+  if (best < 0)
+  {
+    return false;
+  }
+
+  square = freeSquares[best];
+  freeSquares.erase(freeSquares.begin() + best);
+
+  // keep the bottom left quarter, the other three go back on the list
+  while (square.size > size)
+  {
+    GLsizei half = square.size / 2;
+    Square right = { square.x + half, square.y, half };
+    Square top = { square.x, square.y + half, half };
+    Square topRight = { square.x + half, square.y + half, half };
+
+    freeSquares.push_back(right);
+    freeSquares.push_back(top);
+    freeSquares.push_back(topRight);
+
+    square.size = half;
+  }
+
+  return true;
+}
+
+bool ShadowAtlas::Allocate(GLsizei size, int count, ShadowTile* tiles)
+{
+  for (; size >= SHADOW_ATLAS_MIN_TILE; size /= 2)
+  {
+    // a light gets all of its faces at one size or none at all
+    std::vector<Square> before = freeSquares;
+
+    int taken = 0;
+    for (; taken < count; taken++)
+    {
+      Square square;
+      if (!Take(size, square))
+      {
+        break;
+      }
+
+      tiles[taken].x = square.x;
+      tiles[taken].y = square.y;
+      tiles[taken].size = square.size;
+      tiles[taken].rect = glm::vec4(square.x, square.y, square.size, square.size) / (GLfloat)atlasSize;
+    }
+
+    if (taken == count)
+    {
+      return true;
+    }
+
+    freeSquares = before;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    tiles[i].size = 0;
+    tiles[i].rect = glm::vec4(0.0f);
+  }
+
+  return false;
+}
+
+GLsizei ShadowAtlas::TileSizeFor(GLsizei maxSize, GLfloat coverage)
+{
+  GLsizei size = SHADOW_ATLAS_MIN_TILE;
+  while (size < maxSize && size < coverage * maxSize)
+  {
+    size *= 2;
+  }
+
+  return size < maxSize ? size : maxSize;
+}
+
+void ShadowAtlas::Write()
+{
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+
+  // clears only reach the tile being drawn
+  glEnable(GL_SCISSOR_TEST);
+
+  // perspective depth bunches up far from the light, push it back by the
+  // slope as it's drawn. The shaders add a little more along the ray.
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(1.1f, 4.0f);
+}
+
+void ShadowAtlas::WriteTile(const ShadowTile& tile)
+{
+  glViewport(tile.x, tile.y, tile.size, tile.size);
+  glScissor(tile.x, tile.y, tile.size, tile.size);
+  glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void ShadowAtlas::EndWrite()
+{
+  glDisable(GL_SCISSOR_TEST);
+  glDisable(GL_POLYGON_OFFSET_FILL);
+
+  // unbind
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowAtlas::Read(GLenum textureUnit)
+{
+  glActiveTexture(textureUnit);
+  glBindTexture(GL_TEXTURE_2D, shadowMap);
+}
+
+GLfloat ShadowAtlas::GetUsage()
+{
+  double freeArea = 0.0;
+  for (size_t i = 0; i < freeSquares.size(); i++)
+  {
+    freeArea += (double)freeSquares[i].size * freeSquares[i].size;
+  }
+
+  return (GLfloat)(1.0 - freeArea / ((double)atlasSize * atlasSize));
+}
+
+void ShadowAtlas::ClearAtlas()
+{
+  if (FBO)
+  {
+    glDeleteFramebuffers(1, &FBO);
+    FBO = 0;
+  }
+
+  if (shadowMap)
+  {
+    glDeleteTextures(1, &shadowMap);
+    shadowMap = 0;
+  }
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+  ClearAtlas();
+}
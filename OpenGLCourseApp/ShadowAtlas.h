@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "ShadowMap.h"
+
+// A square part of the atlas handed to one face of a light
+struct ShadowTile
+{
+  GLint x, y;
+  GLsizei size;    // 0 when the light didn't get any room
+  glm::vec4 rect;  // the same in 0 to 1 texture coordinates, for the shaders
+};
+
+// Every point and spot light shadow lives in this one depth texture, so
+// the memory they take is fixed no matter how many lights there are.
+//
+// Tiles are squares with power of two sizes, handed out quadtree style:
+// the smallest free square that fits gets split in four until it's the
+// right size. Everything is freed and handed out again each frame, so a
+// light that gets closer to the camera can move up to a bigger tile.
+class ShadowAtlas
+{
+  public:
+    ShadowAtlas();
+
+    // can be called again to resize it, or change the format. Every tile
+    // is freed and whatever was drawn is gone.
+    bool Init(GLuint size, GLenum depthFormat = GL_DEPTH_COMPONENT24);
+
+    // frees every tile
+    void Clear();
+
+    // count tiles of the same size. Halves the size until they all fit,
+    // down to SHADOW_ATLAS_MIN_TILE. False if even that doesn't fit.
+    bool Allocate(GLsizei size, int count, ShadowTile* tiles);
+
+    // How big a light's tiles should be for how much of the screen its
+    // range covers (0 to 1, see ShadowScheduler::ScreenCoverage), from
+    // SHADOW_ATLAS_MIN_TILE up to maxSize
+    static GLsizei TileSizeFor(GLsizei maxSize, GLfloat coverage);
+
+    // bind for drawing, then WriteTile before each face
+    void Write();
+    void WriteTile(const ShadowTile& tile);
+    void EndWrite();
+
+    void Read(GLenum textureUnit);
+
+    GLuint GetSize() { return atlasSize; }
+    // how much of the atlas is handed out, 0 to 1
+    GLfloat GetUsage();
+
+    ~ShadowAtlas();
+
+  private:
+    struct Square
+    {
+      GLint x, y;
+      GLsizei size;
+    };
+
+    GLuint FBO, shadowMap;
+    GLuint atlasSize;
+
+    std::vector<Square> freeSquares;
+
+    bool Take(GLsizei size, Square& square);
+    void ClearAtlas();
+};
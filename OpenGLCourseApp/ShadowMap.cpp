@@ -4,10 +4,44 @@ ShadowMap::ShadowMap()
 {
   FBO = 0;
   shadowMap = 0;
+  shadowWidth = 0;
+  shadowHeight = 0;
 }
 
-bool ShadowMap::Init(GLuint width, GLuint height)
+void ShadowMap::AllocateStorage(GLenum internalFormat, GLsizei width, GLsizei height)
 {
+  if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+  {
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    return;
+  }
+
+  // glTexImage2D still wants a format and type for the (missing) data,
+  // matching them keeps drivers from converting anything
+  GLenum format = GL_DEPTH_COMPONENT;
+  GLenum type = GL_UNSIGNED_INT;
+  switch (internalFormat)
+  {
+    case GL_DEPTH_COMPONENT16:
+      type = GL_UNSIGNED_SHORT;
+      break;
+    case GL_DEPTH_COMPONENT32F:
+      type = GL_FLOAT;
+      break;
+    case GL_RG32F:
+      format = GL_RG;
+      type = GL_FLOAT;
+      break;
+  }
+
+  glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+}
+
+bool ShadowMap::Init(GLuint width, GLuint height, GLenum depthFormat)
+{
+  // storage is immutable, a new size means a new texture
+  ClearShadowMap();
+
   shadowWidth = width;
   shadowHeight = height;
 
@@ -15,10 +49,7 @@ bool ShadowMap::Init(GLuint width, GLuint height)
 
   glGenTextures(1, &shadowMap);
   glBindTexture(GL_TEXTURE_2D, shadowMap);
-  glTexImage2D(
-      GL_TEXTURE_2D,
-      0, GL_DEPTH_COMPONENT, shadowWidth, shadowHeight,
-      0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  AllocateStorage(depthFormat, shadowWidth, shadowHeight);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -27,6 +58,11 @@ bool ShadowMap::Init(GLuint width, GLuint height)
   float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
   glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
+  // sampled as a sampler2DShadow, the texture unit does the depth compare
+  // and filters the results
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
   glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
   glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
 
@@ -57,16 +93,23 @@ void ShadowMap::Read(GLenum textureUnit)
   glBindTexture(GL_TEXTURE_2D, shadowMap);
 }
 
-ShadowMap::~ShadowMap()
+void ShadowMap::ClearShadowMap()
 {
   if (FBO)
   {
     glDeleteFramebuffers(1, &FBO);
+    FBO = 0;
   }
 
   if (shadowMap)
   {
     glDeleteTextures(1, &shadowMap);
+    shadowMap = 0;
   }
 }
 
+ShadowMap::~ShadowMap()
+{
+  ShadowMap::ClearShadowMap();
+}
+
@@ -8,16 +8,26 @@ class ShadowMap
   public:
     ShadowMap();
 
-    virtual bool Init(GLuint width, GLuint height);
+    // can be called again to resize it, or change the format
+    virtual bool Init(GLuint width, GLuint height, GLenum depthFormat = GL_DEPTH_COMPONENT24);
     virtual void Write();
+    // anything done to the map once it's drawn, nothing for plain depth
+    virtual void Filter() {}
     virtual void Read(GLenum textureUnit);
 
     GLuint GetShadowWidth() { return shadowWidth; }
     GLuint GetShadowHeight() { return shadowHeight; }
 
-    ~ShadowMap();
+    // Storage for the bound GL_TEXTURE_2D in exactly the sized format given.
+    // Immutable (glTexStorage2D) where the driver has it, so it never has
+    // to guess at what the texture will be used for.
+    static void AllocateStorage(GLenum internalFormat, GLsizei width, GLsizei height);
+
+    virtual ~ShadowMap();
 
   protected:
     GLuint FBO, shadowMap;
     GLuint shadowWidth, shadowHeight;
+
+    virtual void ClearShadowMap();
 };
@@ -0,0 +1,20 @@
+#include "ShadowQuality.h"
+
+// The atlas holds perspective depth for the point and spot lights, which
+// runs out of precision a lot sooner than the directional light's ortho
+// depth, so it only drops to 16 bits on the lowest tier.
+static const ShadowQuality tiers[ShadowQuality::tierCount] = {
+  { "low",    0.5f, GL_DEPTH_COMPONENT16,  GL_DEPTH_COMPONENT16, 0 },
+  { "medium", 1.0f, GL_DEPTH_COMPONENT24,  GL_DEPTH_COMPONENT24, 1 },
+  { "high",   2.0f, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT24, 2 },
+};
+
+const ShadowQuality& ShadowQuality::Get(int tier)
+{
+  if (tier < 0 || tier >= tierCount)
+  {
+    tier = defaultTier;
+  }
+
+  return tiers[tier];
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// One setting for every shadow map at once: how big they are compared to
+// what each light asked for, how many bits their depth gets and how wide
+// the shaders filter them. Picking another tier rebuilds all of them.
+struct ShadowQuality
+{
+  const char* name;
+  GLfloat scale;
+  GLenum directionalFormat;
+  GLenum atlasFormat;
+  // picks the shader variant, see ShaderKey
+  int pcfRadius;
+
+  static const int tierCount = 3;
+  static const int defaultTier = 1;
+
+  static const ShadowQuality& Get(int tier);
+};
@@ -0,0 +1,211 @@
+#include "ShadowScheduler.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+ShadowScheduler::ShadowScheduler()
+{
+  facesUpdated = 0;
+  lightsCulled = 0;
+}
+
+GLfloat ShadowScheduler::ScreenCoverage(glm::vec3 center, GLfloat radius,
+    glm::vec3 eyePosition, GLfloat fieldOfView)
+{
+  GLfloat distance = glm::length(center - eyePosition);
+  if (distance <= radius)
+  {
+    return 1.0f;
+  }
+
+  return glm::min(radius / (distance * tanf(fieldOfView * 0.5f)), 1.0f);
+}
+
+bool ShadowScheduler::HigherScore(const Entry* a, const Entry* b)
+{
+  return a->score > b->score;
+}
+
+bool ShadowScheduler::HigherPriority(const Entry* a, const Entry* b)
+{
+  // the longer a light waits the more it wants redrawing, so even the
+  // smallest ones get their turn
+  return a->score * (a->age + 1) > b->score * (b->age + 1);
+}
+
+void ShadowScheduler::Schedule(ShadowAtlas& atlas,
+    PointLight* pLights, unsigned int pointLightCount,
+    SpotLight* sLights, unsigned int spotLightCount,
+    const Frustum& cameraFrustum,
+    glm::vec3 eyePosition, GLfloat fieldOfView)
+{
+  unsigned int lightCount = pointLightCount + spotLightCount;
+  std::vector<Entry*> visible;
+
+  lightsCulled = 0;
+  facesUpdated = 0;
+
+  if (entries.size() != lightCount)
+  {
+    entries.resize(lightCount);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+      entries[i].light = nullptr;
+    }
+  }
+
+  for (unsigned int i = 0; i < lightCount; i++)
+  {
+    PointLight* light = i < pointLightCount ?
+      &pLights[i] : &sLights[i - pointLightCount];
+    Entry& entry = entries[i];
+
+    // a different light in this slot, nothing it has drawn counts
+    if (entry.light != light)
+    {
+      entry.light = light;
+      entry.age = 0;
+      for (int face = 0; face < 6; face++)
+      {
+        entry.drawnTiles[face].size = 0;
+      }
+    }
+
+    entry.update = false;
+    entry.score = 0.0f;
+
+    // lights nothing on screen, so there's no shadow of it to see either
+    if (!cameraFrustum.IntersectsSphere(light->GetPosition(), light->GetRange()))
+    {
+      light->ClearShadowTiles();
+      lightsCulled++;
+      continue;
+    }
+
+    entry.score = ScreenCoverage(light->GetPosition(), light->GetRange(), eyePosition, fieldOfView);
+    visible.push_back(&entry);
+  }
+
+  // biggest first, so the small ones fill in the gaps they leave. Whoever's
+  // left once it's full goes without shadows this frame.
+  std::stable_sort(visible.begin(), visible.end(), HigherScore);
+
+  atlas.Clear();
+  for (size_t i = 0; i < visible.size(); i++)
+  {
+    PointLight* light = visible[i]->light;
+    atlas.Allocate(ShadowAtlas::TileSizeFor(light->GetShadowSize(), visible[i]->score),
+        light->GetShadowTileCount(),
+        light->GetShadowTiles());
+  }
+
+  // the ones that have to be drawn go first, whatever they cost
+  std::vector<Entry*> waiting;
+  for (size_t i = 0; i < visible.size(); i++)
+  {
+    if (!visible[i]->light->HasShadowTiles())
+    {
+      continue;
+    }
+
+    if (NeedsRedraw(*visible[i]))
+    {
+      visible[i]->update = true;
+      facesUpdated += visible[i]->light->GetShadowTileCount();
+    }
+    else
+    {
+      waiting.push_back(visible[i]);
+    }
+  }
+
+  // then whatever the budget has left, most wanted first
+  std::stable_sort(waiting.begin(), waiting.end(), HigherPriority);
+
+  for (size_t i = 0; i < waiting.size(); i++)
+  {
+    unsigned int faces = waiting[i]->light->GetShadowTileCount();
+    if (facesUpdated + faces <= (unsigned int)SHADOW_FACE_BUDGET)
+    {
+      waiting[i]->update = true;
+      facesUpdated += faces;
+    }
+  }
+
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    Entry& entry = entries[i];
+    PointLight* light = entry.light;
+
+    if (!light->HasShadowTiles())
+    {
+      // anything it had may be drawn over by now
+      for (int face = 0; face < 6; face++)
+      {
+        entry.drawnTiles[face].size = 0;
+      }
+      continue;
+    }
+
+    if (!entry.update)
+    {
+      entry.age++;
+      continue;
+    }
+
+    entry.age = 0;
+    entry.drawnTransform = light->CalculateLightTransform()[0];
+    for (int face = 0; face < light->GetShadowTileCount(); face++)
+    {
+      entry.drawnTiles[face] = light->GetShadowTiles()[face];
+    }
+  }
+}
+
+bool ShadowScheduler::NeedsRedraw(Entry& entry)
+{
+  PointLight* light = entry.light;
+
+  if (entry.age >= SHADOW_MAX_STALE_FRAMES)
+  {
+    return true;
+  }
+
+  // the shaders look its tiles up where they are now, with the light
+  // where it is now
+  ShadowTile* tiles = light->GetShadowTiles();
+  for (int face = 0; face < light->GetShadowTileCount(); face++)
+  {
+    if (tiles[face].size != entry.drawnTiles[face].size ||
+        tiles[face].x != entry.drawnTiles[face].x ||
+        tiles[face].y != entry.drawnTiles[face].y)
+    {
+      return true;
+    }
+  }
+
+  return light->CalculateLightTransform()[0] != entry.drawnTransform;
+}
+
+void ShadowScheduler::Invalidate()
+{
+  // the same as a new light in every slot
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    entries[i].light = nullptr;
+  }
+}
+
+bool ShadowScheduler::ShouldUpdate(PointLight* light)
+{
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    if (entries[i].light == light)
+    {
+      return entries[i].update;
+    }
+  }
+
+  return false;
+}
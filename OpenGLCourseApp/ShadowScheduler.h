@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CommonValues.h"
+#include "Frustum.h"
+#include "ShadowAtlas.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+
+// Decides, once a frame, which point and spot lights get shadows and which
+// of those are redrawn.
+//
+// Lights are scored by how much of the screen their range covers, which
+// goes down with distance from the camera. Lights whose range is outside
+// the view get nothing. The rest get atlas tiles sized by their score, and
+// then redraws are handed out up to SHADOW_FACE_BUDGET faces a frame. A
+// light that isn't redrawn keeps last frame's tile as it was.
+//
+// Some lights have to be redrawn whatever the budget says: ones whose tile
+// moved, ones that moved themselves, and ones that have waited
+// SHADOW_MAX_STALE_FRAMES. Lights with bigger scores get redrawn more
+// often, so distant ones end up refreshing every few frames.
+class ShadowScheduler
+{
+  public:
+    ShadowScheduler();
+
+    void Schedule(ShadowAtlas& atlas,
+        PointLight* pLights, unsigned int pointLightCount,
+        SpotLight* sLights, unsigned int spotLightCount,
+        const Frustum& cameraFrustum,
+        glm::vec3 eyePosition, GLfloat fieldOfView);
+
+    // whether the light's shadow pass should run this frame
+    bool ShouldUpdate(PointLight* light);
+
+    // the atlas was rebuilt, nothing drawn before counts any more
+    void Invalidate();
+
+    // faces redrawn and lights culled, last Schedule
+    unsigned int GetFacesUpdated() { return facesUpdated; }
+    unsigned int GetLightsCulled() { return lightsCulled; }
+
+    // the light's range against half the height of the screen, 0 to 1.
+    // With the camera inside the range it could be anywhere on screen.
+    static GLfloat ScreenCoverage(glm::vec3 center, GLfloat radius,
+        glm::vec3 eyePosition, GLfloat fieldOfView);
+
+  private:
+    // kept from frame to frame, one per light slot
+    struct Entry
+    {
+      PointLight* light;
+      GLfloat score;
+      int age;          // frames since it was last drawn
+      bool update;
+
+      // what the tiles were drawn with, last time they were
+      ShadowTile drawnTiles[6];
+      glm::mat4 drawnTransform;
+    };
+
+    std::vector<Entry> entries;
+
+    unsigned int facesUpdated, lightsCulled;
+
+    bool NeedsRedraw(Entry& entry);
+
+    static bool HigherScore(const Entry* a, const Entry* b);
+    static bool HigherPriority(const Entry* a, const Entry* b);
+};
@@ -1,5 +1,7 @@
 #include "SpotLight.h"
 
+#include "UniformState.h"
+
 SpotLight::SpotLight() : PointLight()
 {
   direction = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -20,6 +22,11 @@ SpotLight::SpotLight(GLuint shadowWidth, GLuint shadowHeight,
   direction = normalize(glm::vec3(xDir, yDir, zDir));
   edge = edg;
   procEdge = cosf(glm::radians(edge));
+
+  // wide enough for the whole cone plus a little for the filtering, a
+  // perspective can't get anywhere near 180 degrees though
+  GLfloat fieldOfView = glm::min(edge * 2.0f + 2.0f, 170.0f);
+  lightProj = glm::perspective(glm::radians(fieldOfView), 1.0f, near, far);
 }
 
 void SpotLight::UseLight(GLuint ambientIntensityLocation,
@@ -32,17 +39,17 @@ void SpotLight::UseLight(GLuint ambientIntensityLocation,
     GLuint exponentLocation,
     GLuint edgeLocation)
 {
-  glUniform3f(ambientColorLocation, color.x, color.y, color.z);
-  glUniform1f(ambientIntensityLocation, ambientIntensity);
-  glUniform1f(diffuseIntensityLocation, diffuseIntensity);
+  UniformState::Set3f(ambientColorLocation, color.x, color.y, color.z);
+  UniformState::Set1f(ambientIntensityLocation, ambientIntensity);
+  UniformState::Set1f(diffuseIntensityLocation, diffuseIntensity);
 
-  glUniform3f(positionLocation, position.x, position.y, position.z);
-  glUniform1f(constantLocation, constant);
-  glUniform1f(linearLocation, linear);
-  glUniform1f(exponentLocation, exponent);
+  UniformState::Set3f(positionLocation, position.x, position.y, position.z);
+  UniformState::Set1f(constantLocation, constant);
+  UniformState::Set1f(linearLocation, linear);
+  UniformState::Set1f(exponentLocation, exponent);
 
-  glUniform3f(directionLocation, direction.x, direction.y, direction.z);
-  glUniform1f(edgeLocation, procEdge);
+  UniformState::Set3f(directionLocation, direction.x, direction.y, direction.z);
+  UniformState::Set1f(edgeLocation, procEdge);
 }
 
 
@@ -52,4 +59,16 @@ void SpotLight::SetFlash(glm::vec3 pos, glm::vec3 dir)
   direction = dir;
 }
 
+std::vector<glm::mat4> SpotLight::CalculateLightTransform()
+{
+  // lookAt can't work out a view when up and the direction line up
+  glm::vec3 up = fabsf(direction.y) > 0.99f ?
+    glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+  std::vector<glm::mat4> lightMatrices;
+  lightMatrices.push_back(lightProj * glm::lookAt(position, position + direction, up));
+
+  return lightMatrices;
+}
+
 SpotLight::~SpotLight(){}
@@ -28,6 +28,14 @@ class SpotLight : public PointLight
 
     void SetFlash(glm::vec3 pos, glm::vec3 dir);
 
+    // a single perspective view down the cone, so a single atlas tile
+    std::vector<glm::mat4> CalculateLightTransform();
+    int GetShadowTileCount() { return 1; }
+
+    glm::vec3 GetDirection() { return direction; }
+    // cosine of the cone's half angle, what the shader compares against
+    GLfloat GetEdge() { return procEdge; }
+
     ~SpotLight();
 
   private:
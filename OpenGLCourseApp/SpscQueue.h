@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+
+// A fixed size queue between exactly two threads, one that only pushes
+// and one that only pops. Neither side ever takes a lock or waits on the
+// other: each owns one end and only reads the other's.
+template <typename T, size_t capacity>
+class SpscQueue
+{
+  public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // false if it's full
+    bool Push(const T& value)
+    {
+      size_t current = tail.load(std::memory_order_relaxed);
+      size_t next = (current + 1) % slotCount;
+      if (next == head.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+
+      items[current] = value;
+
+      // the item has to be there before the popping side can see it
+      tail.store(next, std::memory_order_release);
+      return true;
+    }
+
+    // false if it's empty
+    bool Pop(T& value)
+    {
+      size_t current = head.load(std::memory_order_relaxed);
+      if (current == tail.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+
+      value = items[current];
+      head.store((current + 1) % slotCount, std::memory_order_release);
+      return true;
+    }
+
+    // for the popping side to check before it waits, without taking
+    // anything out
+    bool Empty() const
+    {
+      return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    // one slot always stays empty, so full and empty look different
+    static const size_t slotCount = capacity + 1;
+
+    T items[slotCount];
+    std::atomic<size_t> head, tail;
+};
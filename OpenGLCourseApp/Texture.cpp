@@ -1,5 +1,12 @@
 #include "Texture.h"
 
+#include <atomic>
+#include <thread>
+
+#include "CommonValues.h"
+#include "FileSystem.h"
+#include "TextureTable.h"
+
 Texture::Texture()
 {
   textureID = 0;
@@ -7,6 +14,9 @@ Texture::Texture()
   height = 0;
   bitDepth = 0;
   fileLocation = "";
+  decodeFailed = false;
+  tableIndex = -1;
+  mipFilter = MIP_FILTER_BOX;
 }
 
 Texture::Texture(const char* fileLoc)
@@ -16,49 +26,95 @@ Texture::Texture(const char* fileLoc)
   height = 0;
   bitDepth = 0;
   fileLocation = fileLoc;
+  decodeFailed = false;
+  tableIndex = -1;
+  mipFilter = MIP_FILTER_BOX;
 }
 
 bool Texture::LoadTexture()
 {
-  unsigned char* texData = stbi_load(fileLocation, &width, &height, &bitDepth, 0);
-  if (!texData)
+  return Upload(GL_RGB);
+}
+
+bool Texture::LoadTextureA()
+{
+  return Upload(GL_RGBA);
+}
+
+bool Texture::Decode()
+{
+  // straight out of the mapped pack when there is one, no extra copy
+  AssetFile file;
+  if (!FileSystem::ReadFile(fileLocation.c_str(), file))
   {
-    printf("Failed to find %s\n", fileLocation);
+    printf("Failed to find: %s\n", fileLocation.c_str());
+    decodeFailed = true;
     return false;
   }
 
-  glGenTextures(1, &textureID);
-  glBindTexture(GL_TEXTURE_2D, textureID);
+  Image image;
+  if (!image.LoadFromMemory(file.GetData(), file.GetSize()))
+  {
+    decodeFailed = true;
+    return false;
+  }
 
-  // repeat on the s (x-axis) and y (y-axis)
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  // whatever the file had, hand the driver tightly packed rgba. That way it
+  // never has to convert on upload and rows are always 4-byte aligned.
+  bitDepth = image.GetChannels();
+  image.ExpandToRGBA();
 
-  // blend the pixels as we move closer to the image
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  width = image.GetWidth();
+  height = image.GetHeight();
 
-  // same as above but as we move further away
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  // build every mip level here rather than with glGenerateMipmap, so the
+  // work happens off the render thread and looks the same on every driver
+  mipChain.Generate(image.GetData(), width, height, mipFilter);
 
-  // for the unsigned byte, remember that char's are just bytes of data!
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData);
+  return true;
+}
 
-  // now generate the mipmaps!
-  glGenerateMipmap(GL_TEXTURE_2D);
+void Texture::DecodeAll(std::vector<Texture*>& textures)
+{
+  std::atomic<size_t> next(0);
 
-  // unbind texture
-  glBindTexture(GL_TEXTURE_2D, 0);
-  stbi_image_free(texData);
+  // each worker keeps grabbing the next texture until they're all done
+  auto worker = [&textures, &next]()
+  {
+    for (size_t i = next++; i < textures.size(); i = next++)
+    {
+      if (textures[i])
+      {
+        textures[i]->Decode();
+      }
+    }
+  };
+
+  size_t threadCount = std::thread::hardware_concurrency();
+  if (threadCount > textures.size())
+  {
+    threadCount = textures.size();
+  }
 
-  return true;
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threadCount; i++)
+  {
+    threads.push_back(std::thread(worker));
+  }
+
+  // the calling thread pitches in as well
+  worker();
+
+  for (size_t i = 0; i < threads.size(); i++)
+  {
+    threads[i].join();
+  }
 }
 
-bool Texture::LoadTextureA()
+bool Texture::Upload(GLint internalFormat)
 {
-  unsigned char* texData = stbi_load(fileLocation, &width, &height, &bitDepth, 0);
-  if (!texData)
+  if (decodeFailed || (!mipChain.GetLevelCount() && !Decode()))
   {
-    printf("Failed to find %s\n", fileLocation);
     return false;
   }
 
@@ -69,29 +125,45 @@ bool Texture::LoadTextureA()
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-  // blend the pixels as we move closer to the image
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  // blend the pixels as we move closer to the image. Materials normally
+  // override this with a sampler object, this is just the fallback.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
   // same as above but as we move further away
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  // for the unsigned byte, remember that char's are just bytes of data!
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData);
+  // upload every level of the chain we built on the CPU
+  int levelCount = mipChain.GetLevelCount();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
 
-  // now generate the mipmaps!
-  glGenerateMipmap(GL_TEXTURE_2D);
+  for (int level = 0; level < levelCount; level++)
+  {
+    // for the unsigned byte, remember that char's are just bytes of data!
+    glTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+        mipChain.GetLevelWidth(level), mipChain.GetLevelHeight(level),
+        0, GL_RGBA, GL_UNSIGNED_BYTE, mipChain.GetLevelData(level));
+  }
 
   // unbind texture
   glBindTexture(GL_TEXTURE_2D, 0);
-  stbi_image_free(texData);
+
+  // it's all on the GPU now, no need to keep a copy around
+  mipChain.ClearMipChain();
 
   return true;
 }
 
 void Texture::UseTexture()
 {
-  // this is referring to the Texture Unit 0
-  glActiveTexture(GL_TEXTURE1);
+  // with the table there is nothing to bind, just say which entry to use
+  if (tableIndex >= 0 && TextureTable::IsActive())
+  {
+    TextureTable::UseEntry(tableIndex);
+    return;
+  }
+
+  glActiveTexture(GL_TEXTURE0 + DIFFUSE_TEXTURE_UNIT);
   glBindTexture(GL_TEXTURE_2D, textureID);
 }
 
@@ -103,6 +175,7 @@ void Texture::ClearTexture()
   height = 0;
   bitDepth = 0;
   fileLocation = "";
+  decodeFailed = false;
 }
 
 Texture::~Texture()
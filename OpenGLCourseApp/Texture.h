@@ -1,9 +1,13 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <GL/glew.h>
 
 // image loading
-#include "stb_image.h"
+#include "Image.h"
+#include "MipChain.h"
 
 class Texture
 {
@@ -15,12 +19,42 @@ class Texture
     bool LoadTexture();   // load non-alpha
     bool LoadTextureA();  // load with alpha
 
+    // The CPU half of loading (decode + mip generation). It doesn't touch
+    // OpenGL so it can run on any thread. LoadTexture() will skip it if it
+    // has already been done, or if it already failed.
+    bool Decode();
+
+    // decode a whole batch at once across all of the cores
+    static void DecodeAll(std::vector<Texture*>& textures);
+
+    void SetMipFilter(MipFilter filter) { mipFilter = filter; }
+
+    GLuint GetTextureID() { return textureID; }
+    int GetWidth() { return width; }
+    int GetHeight() { return height; }
+    const char* GetFileLocation() { return fileLocation.c_str(); }
+
+    // where this texture lives in the TextureTable, -1 if it isn't in there
+    void SetTableIndex(int index) { tableIndex = index; }
+
     void UseTexture();
     void ClearTexture();
 
   private:
+    bool Upload(GLint internalFormat);
+
     GLuint textureID;
     int width, height, bitDepth;
 
-    const char* fileLocation;
+    // owned by us, the path may need to outlive whoever gave it to us now
+    // that decoding can happen later on another thread
+    std::string fileLocation;
+
+    // so a texture that failed in DecodeAll isn't read again on upload
+    bool decodeFailed;
+
+    int tableIndex;
+
+    MipFilter mipFilter;
+    MipChain mipChain;
 };
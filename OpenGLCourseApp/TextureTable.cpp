@@ -0,0 +1,299 @@
+#include "TextureTable.h"
+
+#include "Sampler.h"
+#include "UniformState.h"
+
+TextureTableMode TextureTable::mode = TEXTURE_TABLE_OFF;
+bool TextureTable::built = false;
+std::vector<Texture*> TextureTable::textures;
+GLuint TextureTable::tableBuffer = 0;
+GLuint TextureTable::textureArrays[MAX_TEXTURE_ARRAYS] = { 0 };
+int TextureTable::textureArrayCount = 0;
+GLint TextureTable::indexLocation = -1;
+int TextureTable::currentIndex = -1;
+
+// smallest array size is 64x64, each one after that doubles
+static const int minArrayLog2 = 6;
+
+static int FloorLog2(int value)
+{
+  int result = 0;
+  while (value > 1)
+  {
+    value >>= 1;
+    result++;
+  }
+
+  return result;
+}
+
+TextureTableMode TextureTable::Init(bool allowBindless)
+{
+  mode = allowBindless && GLEW_ARB_bindless_texture ?
+    TEXTURE_TABLE_BINDLESS : TEXTURE_TABLE_ARRAYS;
+
+  printf("Texture table: %s\n",
+      mode == TEXTURE_TABLE_BINDLESS ? "bindless handles" : "texture arrays");
+
+  return mode;
+}
+
+std::string TextureTable::GetShaderDefines()
+{
+  if (mode == TEXTURE_TABLE_OFF)
+  {
+    return "";
+  }
+
+  // the sizes come from CommonValues.glsl, see ShaderIncludes.h
+  return mode == TEXTURE_TABLE_BINDLESS ?
+    "#define TEXTURE_TABLE_BINDLESS\n" :
+    "#define TEXTURE_TABLE_ARRAYS\n";
+}
+
+int TextureTable::Add(Texture* texture)
+{
+  if (mode == TEXTURE_TABLE_OFF || !texture)
+  {
+    return -1;
+  }
+
+  if (textures.size() >= (size_t)MAX_TEXTURE_HANDLES)
+  {
+    printf("Texture table is full, raise MAX_TEXTURE_HANDLES\n");
+    return -1;
+  }
+
+  texture->SetTableIndex(textures.size());
+  textures.push_back(texture);
+
+  // anything added after a build needs another one
+  built = false;
+
+  return textures.size() - 1;
+}
+
+bool TextureTable::Build()
+{
+  if (mode == TEXTURE_TABLE_OFF)
+  {
+    return false;
+  }
+
+  // each entry is a uvec4 since that's how std140 lays out arrays anyway
+  std::vector<GLuint> entries(MAX_TEXTURE_HANDLES * 4, 0);
+
+  if (mode == TEXTURE_TABLE_BINDLESS)
+  {
+    BuildBindless(entries);
+  }
+  else
+  {
+    BuildArrays(entries);
+  }
+
+  if (!tableBuffer)
+  {
+    glGenBuffers(1, &tableBuffer);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, tableBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(entries[0]) * entries.size(), &entries[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  built = true;
+  return true;
+}
+
+void TextureTable::BuildBindless(std::vector<GLuint>& entries)
+{
+  // the sampler state gets baked into the handle, so every texture in the
+  // table uses the default one (trilinear + anisotropic)
+  Sampler* sampler = Sampler::Get(Sampler::DefaultState());
+
+  for (size_t i = 0; i < textures.size(); i++)
+  {
+    GLuint64 handle = glGetTextureSamplerHandleARB(
+        textures[i]->GetTextureID(),
+        sampler->GetSamplerID());
+
+    // handles have to be resident before any shader touches them
+    if (!glIsTextureHandleResidentARB(handle))
+    {
+      glMakeTextureHandleResidentARB(handle);
+    }
+
+    entries[i * 4] = (GLuint)(handle & 0xFFFFFFFF);
+    entries[i * 4 + 1] = (GLuint)(handle >> 32);
+  }
+}
+
+void TextureTable::BuildArrays(std::vector<GLuint>& entries)
+{
+  // sort the textures into one bucket per array size
+  std::vector<int> buckets[MAX_TEXTURE_ARRAYS];
+  for (size_t i = 0; i < textures.size(); i++)
+  {
+    int largest = textures[i]->GetWidth() > textures[i]->GetHeight() ?
+      textures[i]->GetWidth() : textures[i]->GetHeight();
+
+    // round up to a power of two so nothing gets scaled down
+    int bucket = FloorLog2(largest);
+    if ((1 << bucket) < largest)
+    {
+      bucket++;
+    }
+
+    bucket -= minArrayLog2;
+    bucket = bucket < 0 ? 0 : (bucket >= MAX_TEXTURE_ARRAYS ? MAX_TEXTURE_ARRAYS - 1 : bucket);
+    buckets[bucket].push_back(i);
+  }
+
+  ClearArrays();
+
+  // copies happen on the GPU with blits, one framebuffer to read the original
+  // texture and one to write into a layer of the array
+  GLuint framebuffers[2];
+  glGenFramebuffers(2, framebuffers);
+
+  for (int bucket = 0; bucket < MAX_TEXTURE_ARRAYS; bucket++)
+  {
+    if (buckets[bucket].empty())
+    {
+      continue;
+    }
+
+    int arrayIndex = textureArrayCount++;
+    int size = 1 << (bucket + minArrayLog2);
+    int levels = bucket + minArrayLog2 + 1;
+    int layers = buckets[bucket].size();
+
+    glGenTextures(1, &textureArrays[arrayIndex]);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrays[arrayIndex]);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    for (int level = 0; level < levels; level++)
+    {
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8,
+          size >> level, size >> level, layers,
+          0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    for (int layer = 0; layer < layers; layer++)
+    {
+      Texture* texture = textures[buckets[bucket][layer]];
+      int width = texture->GetWidth();
+      int height = texture->GetHeight();
+      int largest = width > height ? width : height;
+      int sourceLevels = FloorLog2(largest) + 1;
+
+      for (int level = 0; level < levels; level++)
+      {
+        // copy from whichever of the texture's own mips is closest in size,
+        // so the blit never has to shrink by more than half
+        int target = size >> level;
+        int source = 0;
+        while (source + 1 < sourceLevels && (largest >> (source + 1)) >= target)
+        {
+          source++;
+        }
+
+        int sourceWidth = width >> source > 0 ? width >> source : 1;
+        int sourceHeight = height >> source > 0 ? height >> source : 1;
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, texture->GetTextureID(), source);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            textureArrays[arrayIndex], level, layer);
+
+        glBlitFramebuffer(0, 0, sourceWidth, sourceHeight,
+            0, 0, target, target,
+            GL_COLOR_BUFFER_BIT, GL_LINEAR);
+      }
+
+      entries[buckets[bucket][layer] * 4] = arrayIndex;
+      entries[buckets[bucket][layer] * 4 + 1] = layer;
+    }
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(2, framebuffers);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureTable::Bind()
+{
+  if (!IsActive())
+  {
+    return;
+  }
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, TEXTURE_TABLE_BINDING, tableBuffer);
+
+  if (mode == TEXTURE_TABLE_ARRAYS)
+  {
+    Sampler* sampler = Sampler::Get(Sampler::DefaultState());
+    for (int i = 0; i < textureArrayCount; i++)
+    {
+      glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT + i);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrays[i]);
+      sampler->Use(TEXTURE_ARRAY_UNIT + i);
+    }
+  }
+}
+
+void TextureTable::SetIndexLocation(GLint location)
+{
+  indexLocation = location;
+
+  // a different program has its own copy of the uniform
+  currentIndex = -1;
+}
+
+void TextureTable::UseEntry(int index)
+{
+  if (indexLocation == -1 || index == currentIndex)
+  {
+    return;
+  }
+
+  UniformState::Set1i(indexLocation, index);
+  currentIndex = index;
+}
+
+void TextureTable::ClearArrays()
+{
+  if (textureArrayCount)
+  {
+    glDeleteTextures(textureArrayCount, textureArrays);
+  }
+
+  for (int i = 0; i < MAX_TEXTURE_ARRAYS; i++)
+  {
+    textureArrays[i] = 0;
+  }
+
+  textureArrayCount = 0;
+}
+
+void TextureTable::ClearTable()
+{
+  ClearArrays();
+
+  if (tableBuffer)
+  {
+    glDeleteBuffers(1, &tableBuffer);
+    tableBuffer = 0;
+  }
+
+  for (size_t i = 0; i < textures.size(); i++)
+  {
+    textures[i]->SetTableIndex(-1);
+  }
+
+  textures.clear();
+  built = false;
+}
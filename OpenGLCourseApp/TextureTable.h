@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "CommonValues.h"
+#include "Texture.h"
+
+enum TextureTableMode
+{
+  TEXTURE_TABLE_OFF = 0,
+  TEXTURE_TABLE_BINDLESS,
+  TEXTURE_TABLE_ARRAYS
+};
+
+// A table of every texture in the scene stored in a uniform buffer, so a draw
+// only has to say which entry it wants instead of rebinding a texture unit.
+// That means draws with different textures can be merged together.
+//
+// With ARB_bindless_texture each entry is a bindless handle. Without it the
+// textures are copied into a few texture arrays (one per size, smaller ones
+// get scaled up) and each entry is the array and layer to sample from.
+class TextureTable
+{
+  public:
+    // picks the mode, has to be called once there is an OpenGL context
+    static TextureTableMode Init(bool allowBindless = true);
+    static TextureTableMode GetMode() { return mode; }
+
+    // the defines a shader needs to read from the table in the current mode
+    static std::string GetShaderDefines();
+
+    // call after the texture has been uploaded. Returns its slot, or -1 if
+    // the table is off or full.
+    static int Add(Texture* texture);
+
+    // builds the handles or arrays for everything that was added
+    static bool Build();
+    static bool IsActive() { return mode != TEXTURE_TABLE_OFF && built; }
+
+    // binds the table buffer (and the arrays) for the upcoming draws
+    static void Bind();
+
+    // the "textureIndex" uniform of whatever program is in use
+    static void SetIndexLocation(GLint location);
+    static void UseEntry(int index);
+
+    static void ClearTable();
+
+  private:
+    static TextureTableMode mode;
+    static bool built;
+
+    static std::vector<Texture*> textures;
+
+    static GLuint tableBuffer;
+    static GLuint textureArrays[MAX_TEXTURE_ARRAYS];
+    static int textureArrayCount;
+
+    static GLint indexLocation;
+    static int currentIndex;
+
+    static void BuildBindless(std::vector<GLuint>& entries);
+    static void BuildArrays(std::vector<GLuint>& entries);
+    static void ClearArrays();
+};
@@ -0,0 +1,121 @@
+#include "UniformState.h"
+
+#include <string.h>
+
+GLuint UniformState::currentProgram = 0;
+std::vector<UniformState::Value>* UniformState::currentValues = nullptr;
+std::unordered_map<GLuint, std::vector<UniformState::Value> > UniformState::programs;
+
+unsigned int UniformState::skippedCount = 0;
+unsigned int UniformState::sentCount = 0;
+
+void UniformState::UseProgram(GLuint program)
+{
+  if (program == currentProgram)
+  {
+    return;
+  }
+
+  glUseProgram(program);
+  currentProgram = program;
+  currentValues = program ? &programs[program] : nullptr;
+}
+
+void UniformState::ForgetProgram(GLuint program)
+{
+  programs.erase(program);
+
+  if (program == currentProgram)
+  {
+    // GL unbinds a deleted program once it stops being current, so make
+    // sure the next UseProgram actually goes through
+    currentProgram = 0;
+    currentValues = nullptr;
+  }
+}
+
+void UniformState::Set1i(GLint location, GLint value)
+{
+  if (Changed(location, &value, sizeof(value)))
+  {
+    glUniform1i(location, value);
+  }
+}
+
+void UniformState::Set1f(GLint location, GLfloat value)
+{
+  if (Changed(location, &value, sizeof(value)))
+  {
+    glUniform1f(location, value);
+  }
+}
+
+void UniformState::Set2f(GLint location, GLfloat x, GLfloat y)
+{
+  GLfloat value[2] = { x, y };
+  if (Changed(location, value, sizeof(value)))
+  {
+    glUniform2f(location, x, y);
+  }
+}
+
+void UniformState::Set3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+  GLfloat value[3] = { x, y, z };
+  if (Changed(location, value, sizeof(value)))
+  {
+    glUniform3f(location, x, y, z);
+  }
+}
+
+void UniformState::Set4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  GLfloat value[4] = { x, y, z, w };
+  if (Changed(location, value, sizeof(value)))
+  {
+    glUniform4f(location, x, y, z, w);
+  }
+}
+
+void UniformState::SetMatrix4fv(GLint location, const GLfloat* value)
+{
+  if (Changed(location, value, sizeof(GLfloat) * 16))
+  {
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+  }
+}
+
+bool UniformState::Changed(GLint location, const void* data, size_t size)
+{
+  // -1 is a uniform the program doesn't have, GL would ignore it anyway
+  if (location < 0)
+  {
+    return false;
+  }
+
+  // nothing tracked (no program bound through here), just send it
+  if (!currentValues)
+  {
+    sentCount++;
+    return true;
+  }
+
+  if ((size_t)location >= currentValues->size())
+  {
+    Value empty;
+    memset(&empty, 0, sizeof(empty));
+    currentValues->resize(location + 1, empty);
+  }
+
+  Value& value = (*currentValues)[location];
+  if (value.set && memcmp(value.words, data, size) == 0)
+  {
+    skippedCount++;
+    return false;
+  }
+
+  memcpy(value.words, data, size);
+  value.set = true;
+  sentCount++;
+  return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Keeps a copy of every uniform value sent to each program and only calls
+// glUniform* when the value actually changes. Uniforms belong to the
+// program, so switching programs back and forth doesn't lose anything.
+//
+// Everything that sets uniforms should go through here, a glUniform* call
+// behind its back would leave the copy out of date.
+class UniformState
+{
+  public:
+    // binds the program, skipped if it's already bound
+    static void UseProgram(GLuint program);
+    // call when a program is deleted, the id can get handed out again
+    static void ForgetProgram(GLuint program);
+
+    static void Set1i(GLint location, GLint value);
+    static void Set1f(GLint location, GLfloat value);
+    static void Set2f(GLint location, GLfloat x, GLfloat y);
+    static void Set3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+    static void Set4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    static void SetMatrix4fv(GLint location, const GLfloat* value);
+
+    // how many glUniform* calls were skipped, for profiling
+    static unsigned int GetSkippedCount() { return skippedCount; }
+    static unsigned int GetSentCount() { return sentCount; }
+    static void ResetCounts() { skippedCount = 0; sentCount = 0; }
+
+  private:
+    struct Value
+    {
+      GLuint words[16];
+      bool set;
+    };
+
+    static GLuint currentProgram;
+    static std::vector<Value>* currentValues;
+    static std::unordered_map<GLuint, std::vector<Value> > programs;
+
+    static unsigned int skippedCount;
+    static unsigned int sentCount;
+
+    // true (and the copy updated) when the value differs from the last one sent
+    static bool Changed(GLint location, const void* data, size_t size);
+};
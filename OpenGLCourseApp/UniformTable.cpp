@@ -0,0 +1,104 @@
+#include "UniformTable.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+static uint32_t HashUniformContinue(const char* text, uint32_t hash)
+{
+  for (; *text; text++)
+  {
+    hash = (hash ^ (unsigned char)*text) * 16777619u;
+  }
+
+  return hash;
+}
+
+uint32_t HashUniformIndexed(const char* prefix, int index, const char* suffix)
+{
+  char digits[16];
+  snprintf(digits, sizeof(digits), "[%d]", index);
+
+  uint32_t hash = HashUniformContinue(prefix, 2166136261u);
+  hash = HashUniformContinue(digits, hash);
+  return HashUniformContinue(suffix, hash);
+}
+
+UniformTable::UniformTable(){}
+
+void UniformTable::Build(GLuint program)
+{
+  ClearTable();
+
+  GLint uniformCount = 0, maxNameLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+  if (uniformCount <= 0)
+  {
+    return;
+  }
+
+  // room to append an array index to the longest name
+  std::vector<char> name(maxNameLength + 16);
+  locations.reserve(uniformCount);
+
+  for (GLint i = 0; i < uniformCount; i++)
+  {
+    GLint size = 0;
+    GLenum type = 0;
+    GLsizei length = 0;
+    glGetActiveUniform(program, i, maxNameLength, &length, &size, &type, &name[0]);
+
+    // uniforms inside a block don't have a location, they're set through
+    // a buffer instead
+    GLint location = glGetUniformLocation(program, &name[0]);
+    if (location < 0)
+    {
+      continue;
+    }
+
+    AddName(&name[0], location);
+
+    // Arrays of plain types come back once as "name[0]" with a size. Make
+    // "name" find the first element too, and look up the rest since GL
+    // doesn't promise they're one after the other.
+    if (length > 3 && strcmp(&name[length - 3], "[0]") == 0)
+    {
+      name[length - 3] = '\0';
+      AddName(&name[0], location);
+
+      for (GLint element = 1; element < size; element++)
+      {
+        char* end = &name[0] + length - 3;
+        snprintf(end, 16, "[%d]", element);
+        AddName(&name[0], glGetUniformLocation(program, &name[0]));
+      }
+    }
+  }
+}
+
+GLint UniformTable::Find(uint32_t id) const
+{
+  std::unordered_map<uint32_t, GLint>::const_iterator found = locations.find(id);
+  return found == locations.end() ? -1 : found->second;
+}
+
+void UniformTable::ClearTable()
+{
+  locations.clear();
+}
+
+void UniformTable::AddName(const char* name, GLint location)
+{
+  uint32_t id = HashUniform(name);
+
+  std::pair<std::unordered_map<uint32_t, GLint>::iterator, bool> added =
+    locations.insert(std::make_pair(id, location));
+
+  if (!added.second && added.first->second != location)
+  {
+    printf("Uniform name hash collision on %s\n", name);
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <type_traits>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+// FNV-1a of a uniform name. constexpr, so names written out in the code
+// get hashed by the compiler rather than every time they're looked up.
+constexpr uint32_t HashUniform(const char* name, uint32_t hash = 2166136261u)
+{
+  return *name ? HashUniform(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+// hash of "prefix[index]suffix" without building the string
+uint32_t HashUniformIndexed(const char* prefix, int index, const char* suffix);
+
+// forces the hash to happen at compile time, use it for literal names
+#define UNIFORM_ID(name) (std::integral_constant<uint32_t, HashUniform(name)>::value)
+
+// Every active uniform in a program, found by asking GL what the program
+// actually uses rather than guessing names. Anything the program doesn't
+// have just isn't in the table, and looking it up costs no GL call.
+class UniformTable
+{
+  public:
+    UniformTable();
+
+    void Build(GLuint program);
+
+    // -1 when the program doesn't use it, which glUniform* quietly ignores
+    GLint Find(uint32_t id) const;
+
+    size_t GetCount() const { return locations.size(); }
+
+    void ClearTable();
+
+  private:
+    std::unordered_map<uint32_t, GLint> locations;
+
+    void AddName(const char* name, GLint location);
+};
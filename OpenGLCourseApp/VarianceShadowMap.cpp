@@ -0,0 +1,169 @@
+#include "VarianceShadowMap.h"
+
+#include "UniformState.h"
+#include "UniformTable.h"
+
+// read from the same unit the lighting shaders get the map on, it'll be
+// bound there again before they run
+static const GLuint blurTextureUnit = 2;
+
+VarianceShadowMap::VarianceShadowMap() : ShadowMap()
+{
+  depthBuffer = 0;
+  blurFBO = 0;
+  blurMap = 0;
+  emptyVAO = 0;
+}
+
+GLuint VarianceShadowMap::CreateMomentsTexture()
+{
+  // 32 bit floats, depth squared loses too much at half precision
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  AllocateStorage(GL_RG32F, shadowWidth, shadowHeight);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  // as far away as it gets, so outside the map is lit
+  float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+  return texture;
+}
+
+bool VarianceShadowMap::Init(GLuint width, GLuint height, GLenum depthFormat)
+{
+  ClearShadowMap();
+
+  shadowWidth = width;
+  shadowHeight = height;
+
+  shadowMap = CreateMomentsTexture();
+  blurMap = CreateMomentsTexture();
+
+  glGenRenderbuffers(1, &depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, shadowWidth, shadowHeight);
+
+  glGenFramebuffers(1, &FBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shadowMap, 0);
+  glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+  GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    printf("Variance Shadow Map Framebuffer Error: %i\n", status);
+    return false;
+  }
+
+  glGenFramebuffers(1, &blurFBO);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, blurFBO);
+  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurMap, 0);
+
+  status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    printf("Variance Shadow Blur Framebuffer Error: %i\n", status);
+    return false;
+  }
+
+  // unbind framebuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // the same whatever size the map is, only made the first time
+  if (!emptyVAO)
+  {
+    blurShader.CreateFromFiles("Shaders/deferred_fullscreen.vert", "Shaders/shadow_blur.frag");
+    glGenVertexArrays(1, &emptyVAO);
+  }
+
+  return true;
+}
+
+void VarianceShadowMap::Write()
+{
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+
+  // everything starts out as far as it can be
+  GLfloat farthest[] = { 1.0f, 1.0f, 0.0f, 0.0f };
+  glClearBufferfv(GL_COLOR, 0, farthest);
+}
+
+void VarianceShadowMap::BlurPass(GLuint source, GLuint targetFBO, GLfloat x, GLfloat y)
+{
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+
+  glActiveTexture(GL_TEXTURE0 + blurTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, source);
+
+  // one texel along the direction being blurred
+  UniformState::Set2f(blurShader.GetUniformLocation(UNIFORM_ID("blurStep")),
+      x / shadowWidth, y / shadowHeight);
+
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void VarianceShadowMap::Filter()
+{
+  // the blur covers every texel, there's nothing to test against
+  glDisable(GL_DEPTH_TEST);
+  glViewport(0, 0, shadowWidth, shadowHeight);
+
+  blurShader.UseShader();
+  UniformState::Set1i(blurShader.GetUniformLocation(UNIFORM_ID("moments")), blurTextureUnit);
+  glBindVertexArray(emptyVAO);
+
+  // a 2D gaussian is the same as blurring across and then down, so two
+  // passes of a few taps instead of one of a few squared
+  BlurPass(shadowMap, blurFBO, 1.0f, 0.0f);
+  BlurPass(blurMap, FBO, 0.0f, 1.0f);
+
+  glBindVertexArray(0);
+  glEnable(GL_DEPTH_TEST);
+
+  // unbind
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void VarianceShadowMap::Read(GLenum textureUnit)
+{
+  glActiveTexture(textureUnit);
+  glBindTexture(GL_TEXTURE_2D, shadowMap);
+}
+
+void VarianceShadowMap::ClearShadowMap()
+{
+  if (blurFBO)
+  {
+    glDeleteFramebuffers(1, &blurFBO);
+    blurFBO = 0;
+  }
+
+  if (blurMap)
+  {
+    glDeleteTextures(1, &blurMap);
+    blurMap = 0;
+  }
+
+  if (depthBuffer)
+  {
+    glDeleteRenderbuffers(1, &depthBuffer);
+    depthBuffer = 0;
+  }
+
+  ShadowMap::ClearShadowMap();
+}
+
+VarianceShadowMap::~VarianceShadowMap()
+{
+  ClearShadowMap();
+
+  if (emptyVAO)
+  {
+    glDeleteVertexArrays(1, &emptyVAO);
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ShadowMap.h"
+#include "Shader.h"
+
+// A shadow map that keeps depth and depth squared instead of just depth
+// (variance shadow mapping). Unlike plain depth those can be filtered, so
+// the whole map is blurred once after it's drawn and the lighting shader
+// gets soft shadows from a single lookup, instead of a PCF tap per texel.
+//
+// Drawn with variance_shadow_map.frag, read as RG in the shaders.
+class VarianceShadowMap : public ShadowMap
+{
+  public:
+    VarianceShadowMap();
+
+    // depthFormat is only for the depth buffer it's drawn with, the
+    // moments are always 32 bit floats
+    bool Init(GLuint width, GLuint height, GLenum depthFormat = GL_DEPTH_COMPONENT24);
+    void Write();
+    void Filter();
+    void Read(GLenum textureUnit);
+
+    ~VarianceShadowMap();
+
+  private:
+    // the moments are drawn into shadowMap (with a depth buffer to test
+    // against), blurred across into blurMap and back down again
+    GLuint depthBuffer;
+    GLuint blurFBO, blurMap;
+    GLuint emptyVAO;
+
+    Shader blurShader;
+
+    GLuint CreateMomentsTexture();
+    void BlurPass(GLuint source, GLuint targetFBO, GLfloat x, GLfloat y);
+
+    void ClearShadowMap();
+};
@@ -4,6 +4,10 @@
 #include <string.h>
 #include <cmath> // abs()
 #include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -17,35 +21,54 @@
 #include "Window.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
+#include "ShaderWatcher.h"
+#include "UniformState.h"
+#include "DrawData.h"
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "SpscQueue.h"
+#include "SampleCounter.h"
+#include "DeferredRenderer.h"
 #include "Camera.h"
 #include "Texture.h"
 #include "DirectionalLight.h"
 #include "PointLight.h"
 #include "SpotLight.h"
+#include "ShadowAtlas.h"
+#include "ShadowScheduler.h"
+#include "ShadowQuality.h"
+#include "Frustum.h"
 #include "Material.h"
+#include "TextureTable.h"
+#include "FileSystem.h"
 
 #include "Model.h"
 
 // Window dimensions
 const float toRadians = 3.14159265f / 180.0f;
 
+// the camera's vertical field of view, shadow tiles get sized against it
+const float fieldOfView = 60.0f * toRadians;
+
 // Uniform globals used for rendering
 GLuint uniformProjection = 0,
-       uniformModel = 0,
        uniformView = 0,
        uniformEyePosition = 0,
        uniformSpecularIntensity = 0,
-       uniformShininess = 0,
-       uniformOmniLightPos = 0,
-       uniformFarPlane = 0;
+       uniformShininess = 0;
 
 Window mainWindow;
 
 std::vector<Mesh*> meshList;
 
-std::vector<Shader> shaderList;
+// pointers, so the shader watcher can find the ones we actually render with
+std::vector<Shader*> shaderList;
+// specialised builds of shaderList[0] for the current lights and settings
+ShaderVariants lightingShaders;
 Shader directionalShadowShader;
-Shader omniShadowShader;
+Shader atlasShadowShader;
+Shader depthPrepassShader;
 
 Camera camera;
 
@@ -59,6 +82,84 @@ Material dullMaterial;
 Model xwing;
 Model blackhawk;
 
+// Everything drawn each frame. Either a single mesh with its texture, or a
+// whole model that brings its own textures.
+struct SceneObject
+{
+  Mesh* mesh;
+  Texture* texture;
+  Model* model;
+  Material* material;
+  glm::mat4 transform;
+  int drawID;
+
+  // a sphere around all of it in world space, for culling
+  glm::vec3 boundsCenter;
+  GLfloat boundsRadius;
+};
+
+// Everything the GL thread needs to draw one frame, made by the
+// simulation thread. There are two of them, so the next frame can be
+// simulated while this one is drawn, see SimulationLoop.
+struct FrameState
+{
+  std::vector<SceneObject> sceneObjects;
+
+  glm::mat4 viewMatrix;
+  glm::vec3 eyePosition;
+  glm::vec3 eyeDirection;
+
+  // Shadow passes only draw the objects that can cast a shadow the camera
+  // will see, the main passes only what's in view.
+  Frustum cameraFrustum;
+
+  // recorded by RecordCameraPasses, replayed on the GL thread
+  CommandList mainCommands;
+  CommandList depthCommands;
+  CommandList directionalCommands;
+
+  // the input as the GL thread last saw it, handed over with the empty
+  // frame since only that thread can poll for it
+  bool keys[1024];
+  GLfloat xChange;
+  GLfloat yChange;
+};
+
+// Frames go round between the two threads: the simulation takes an empty
+// one, fills it and hands it over to be drawn, and it comes back empty.
+FrameState frameStates[2];
+SpscQueue<FrameState*, 2> readyFrames;
+SpscQueue<FrameState*, 2> emptyFrames;
+std::atomic<bool> simulationRunning(false);
+
+// Whichever thread finds its queue empty sleeps on these until the other
+// one pushes, or until the simulation is told to stop.
+std::mutex frameMutex;
+std::condition_variable emptyFrameReady;
+std::condition_variable readyFrameReady;
+
+// Pushes and wakes the other thread. The lock is only taken so the wake
+// can't land between the other thread finding the queue empty and going
+// to sleep on it.
+void HandOver(SpscQueue<FrameState*, 2>& queue, std::condition_variable& ready, FrameState* frame)
+{
+  // can't be full, there are only ever two frames
+  queue.Push(frame);
+  {
+    std::lock_guard<std::mutex> lock(frameMutex);
+  }
+  ready.notify_one();
+}
+
+// The atlas lists are recorded on the GL thread, by RecordShadowPasses,
+// since the lights and the atlas belong to it. Each point light face and
+// each spot light gets a list of its own, see AtlasCommands.
+CommandList atlasCommands[MAX_POINT_LIGHTS * 6 + MAX_SPOT_LIGHTS];
+
+// each point and spot light's view of the atlas, worked out alongside the
+// rest of the frame's jobs. Laid out like atlasCommands, see ShadowMatrices.
+std::vector<glm::mat4> shadowMatrices[MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS];
+
 DirectionalLight mainLight;
 PointLight pointLights[MAX_POINT_LIGHTS];
 SpotLight spotLights[MAX_SPOT_LIGHTS];
@@ -66,9 +167,31 @@ SpotLight spotLights[MAX_SPOT_LIGHTS];
 unsigned int pointLightCount = 0;
 unsigned int spotLightCount = 0;
 
+// every point and spot light shadow, tiles handed out again each frame
+ShadowAtlas shadowAtlas;
+ShadowScheduler shadowScheduler;
+
+// Q steps through the tiers, see ShadowQuality.h
+int shadowQualityTier = ShadowQuality::defaultTier;
+bool qualityKeyHeld = false;
+
+// Lay down depth first so the lighting shader only runs once per visible
+// pixel. Toggled with P, which also prints how many fragments the last
+// frame shaded, so the two can be compared.
+bool depthPrepassEnabled = true;
+bool prepassKeyHeld = false;
+SampleCounter shadedFragments;
+
+// G toggles between the forward shader and the deferred renderer, and
+// prints the fragments shaded like P does
+DeferredRenderer deferredRenderer;
+bool deferredEnabled = false;
+bool deferredKeyHeld = false;
+
 GLfloat deltaTime = 0.0f;
 GLfloat lastTime = 0.0f;
 
+// only ever touched by the simulation thread
 GLfloat blackhawkAngle = 0.0f;
 
 // Vertex Shader
@@ -186,80 +309,420 @@ void CreateObjects()
   meshList.push_back(obj3);
 }
 
+// Every program is only submitted here. The driver builds them while the
+// models and textures load, and each one is waited on at its first use.
 void CreateShaders()
 {
   Shader *shader1 = new Shader();
+  shader1->SetDefines(TextureTable::GetShaderDefines());
   shader1->CreateFromFiles(vShader, fShader);
-  shaderList.push_back(*shader1);
+  shaderList.push_back(shader1);
+
+  lightingShaders.SetFiles(vShader, fShader);
+  lightingShaders.SetBaseDefines(TextureTable::GetShaderDefines());
 
+  // variance shadows write out depth and depth squared, plain ones only
+  // need the depth buffer
   directionalShadowShader = Shader();
   directionalShadowShader.CreateFromFiles(
       "Shaders/directional_shadow_map.vert",
+      VARIANCE_SHADOWS ?
+        "Shaders/variance_shadow_map.frag" :
+        "Shaders/directional_shadow_map.frag");
+
+  // point and spot lights both keep plain perspective depth in the atlas,
+  // so nothing is written by hand and early depth testing stays on
+  atlasShadowShader = Shader();
+  atlasShadowShader.CreateFromFiles(
+      "Shaders/atlas_shadow_map.vert",
+      "Shaders/directional_shadow_map.frag");
+
+  // positions only, the fragment shader is the same empty one the
+  // directional shadows use
+  depthPrepassShader = Shader();
+  depthPrepassShader.CreateFromFiles(
+      "Shaders/depth_prepass.vert",
       "Shaders/directional_shadow_map.frag");
 
-  omniShadowShader = Shader();
-  omniShadowShader.CreateFromFiles(
-      "Shaders/omni_shadow_map.vert",
-      "Shaders/omni_shadow_map.geom",
-      "Shaders/omni_shadow_map.frag");
+  deferredRenderer.Init(
+      mainWindow.getBufferWidth(),
+      mainWindow.getBufferHeight(),
+      TextureTable::GetShaderDefines());
 }
 
-void RenderScene()
+void AddObject(FrameState& frame, Mesh* mesh, Texture* texture, Model* model,
+    Material* material, const glm::mat4& transform)
 {
-  // Position and draw the first mesh
+  SceneObject object;
+  object.mesh = mesh;
+  object.texture = texture;
+  object.model = model;
+  object.material = material;
+  object.transform = transform;
+
+  // DrawData hands out ids in the order things are added, and UploadScene
+  // adds them in this order. Anything past the limit is left out of every
+  // pass, see RecordObject.
+  int drawID = (int)frame.sceneObjects.size();
+  object.drawID = drawID < MAX_DRAWS_PER_FRAME ? drawID : -1;
+
+  // the sphere around the box, scaled by the biggest the transform
+  // stretches anything
+  glm::vec3 boundsMin = model ? model->GetBoundsMin() : mesh->GetBoundsMin();
+  glm::vec3 boundsMax = model ? model->GetBoundsMax() : mesh->GetBoundsMax();
+  GLfloat scale = glm::max(glm::length(glm::vec3(transform[0])),
+      glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+  object.boundsCenter = glm::vec3(transform * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+  object.boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f * scale;
+
+  frame.sceneObjects.push_back(object);
+}
+
+// Works out where everything is this frame. The passes below only draw
+// what's in the frame's sceneObjects. Runs on the simulation thread, so
+// no GL in here.
+void UpdateScene(FrameState& frame)
+{
+  frame.sceneObjects.clear();
+
+  // Position the first mesh
   glm::mat4 model(1.0f);
   model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.5f));
   model = glm::rotate(model, 0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-  glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-  brickTexture.UseTexture();
-  shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-  meshList[0]->RenderMesh();
+  AddObject(frame, meshList[0], &brickTexture, nullptr, &shinyMaterial, model);
 
-  // Position and draw the second mesh
+  // Position the second mesh
   model = glm::mat4(1.0f);
   model = glm::translate(model, glm::vec3(0.0f, 4.0f, -2.5f));
   model = glm::rotate(model, 0.0f, glm::vec3(0.0f, -1.0f, 0.0f));
-  glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-  dirtTexture.UseTexture();
-  dullMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-  meshList[1]->RenderMesh();
+  AddObject(frame, meshList[1], &dirtTexture, nullptr, &dullMaterial, model);
 
-  // Position and draw the third mesh
+  // Position the third mesh
   model = glm::mat4(1.0f);
   model = glm::translate(model, glm::vec3(0.0f, -2.0f, 0.0f));
-  glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-  dirtTexture.UseTexture();
-  shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-  meshList[2]->RenderMesh();
+  AddObject(frame, meshList[2], &dirtTexture, nullptr, &shinyMaterial, model);
 
-  // Render the xwing model
+  // Position the xwing model
   model = glm::mat4(1.0f);
   model = glm::translate(model, glm::vec3(-7.0f, 0.0f, 10.0f));
   model = glm::scale(model, glm::vec3(0.006, 0.006f, 0.006f));
-  glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-  shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-  xwing.RenderModel();
+  AddObject(frame, nullptr, nullptr, &xwing, &shinyMaterial, model);
 
-  // move the blackhawk model
+  // move the blackhawk model. This is once a frame now, it used to happen
+  // once for every pass that drew the scene
   blackhawkAngle += 0.1f;
   if (blackhawkAngle > 360.0f)
   {
     blackhawkAngle = 0.1f;
   }
 
-  // Render the blackhawk model
+  // Position the blackhawk model
   model = glm::mat4(1.0f);
   model = glm::rotate(model, -blackhawkAngle * toRadians, glm::vec3(0.0f, 1.0f, 0.0f));
   model = glm::translate(model, glm::vec3(-8.0f, 2.0f, 0.0f));
   model = glm::rotate(model, -20.0f * toRadians, glm::vec3(0.0f, 0.0f, 1.0f));
   model = glm::rotate(model, -90.0f * toRadians, glm::vec3(1.0f, 0.0f, 0.0f));
   model = glm::scale(model, glm::vec3(0.4, 0.4f, 0.4f));
-  glUniformMatrix4fv(uniformModel, 1, GL_FALSE, glm::value_ptr(model));
-  shinyMaterial.UseMaterial(uniformSpecularIntensity, uniformShininess);
-  blackhawk.RenderModel();
+  AddObject(frame, nullptr, nullptr, &blackhawk, &shinyMaterial, model);
+}
+
+// sends every object's matrix and material to the GPU in one go
+void UploadScene(FrameState& frame)
+{
+  DrawData::BeginFrame();
+
+  for (size_t i = 0; i < frame.sceneObjects.size(); i++)
+  {
+    SceneObject& object = frame.sceneObjects[i];
+    DrawData::Add(object.transform,
+        object.material->GetSpecularIntensity(),
+        object.material->GetShininess());
+  }
+
+  DrawData::Upload();
+}
+
+// Nothing in here touches GL, it's safe from any thread as long as the
+// scene isn't changing.
+void RecordObject(CommandList& list, SceneObject& object, bool withMaterials)
+{
+  // past the DrawData limit, there's nothing on the GPU for it to read
+  if (object.drawID < 0)
+  {
+    return;
+  }
+
+  // the model matrix and material are already on the GPU, just say which
+  list.SetDraw(object.drawID);
+
+  if (withMaterials)
+  {
+    list.SetMaterial(object.material);
+  }
+
+  if (object.model)
+  {
+    list.DrawModel(object.model, withMaterials);
+  }
+  else
+  {
+    if (withMaterials)
+    {
+      list.BindTexture(object.texture);
+    }
+
+    list.DrawMesh(object.mesh);
+  }
+}
+
+// Whatever's in the camera's view. Depth only passes (the pre-pass) skip
+// the textures and materials.
+void RecordScene(CommandList& list, FrameState& frame, bool withMaterials)
+{
+  list.Clear();
+
+  for (size_t i = 0; i < frame.sceneObjects.size(); i++)
+  {
+    SceneObject& object = frame.sceneObjects[i];
+
+    if (frame.cameraFrustum.IntersectsSphere(object.boundsCenter, object.boundsRadius))
+    {
+      RecordObject(list, object, withMaterials);
+    }
+  }
+}
+
+// depth only, whatever Record*Casters put in the list
+void RenderCasters(CommandList& list)
+{
+  list.Execute(-1, -1);
+}
+
+// Objects in the directional light's box whose shadow, pushed along the
+// light's direction as far as the box goes, can land in the camera's view.
+void RecordDirectionalCasters(CommandList& list, FrameState& frame,
+    const Frustum& lightFrustum, DirectionalLight* light)
+{
+  list.Clear();
+  glm::vec3 reach = glm::normalize(light->GetDirection()) * light->GetShadowDepth();
+
+  for (size_t i = 0; i < frame.sceneObjects.size(); i++)
+  {
+    SceneObject& object = frame.sceneObjects[i];
+
+    if (lightFrustum.IntersectsSphere(object.boundsCenter, object.boundsRadius) &&
+        frame.cameraFrustum.IntersectsSweptSphere(object.boundsCenter,
+          object.boundsCenter + reach, object.boundsRadius))
+    {
+      RecordObject(list, object, false);
+    }
+  }
+}
+
+// Same for a point or spot light, within its range and the view it's
+// drawing. Shadows here spread out away from the light, so the sweep gets
+// as wide as the shadow is by the time it's out of range.
+void RecordPointCasters(CommandList& list, FrameState& frame,
+    const Frustum& lightFrustum, PointLight* light)
+{
+  list.Clear();
+  glm::vec3 lightPos = light->GetPosition();
+  GLfloat range = light->GetRange();
+
+  for (size_t i = 0; i < frame.sceneObjects.size(); i++)
+  {
+    SceneObject& object = frame.sceneObjects[i];
+    glm::vec3 toObject = object.boundsCenter - lightPos;
+    GLfloat distance = glm::length(toObject);
+
+    // nowhere near the light
+    if (distance - object.boundsRadius > range ||
+        !lightFrustum.IntersectsSphere(object.boundsCenter, object.boundsRadius))
+    {
+      continue;
+    }
+
+    // the light is inside it, its shadow could be anywhere
+    if (distance <= object.boundsRadius * 1.01f)
+    {
+      RecordObject(list, object, false);
+      continue;
+    }
+
+    GLfloat shadowRadius = object.boundsRadius * range /
+      sqrtf(distance * distance - object.boundsRadius * object.boundsRadius);
+
+    if (frame.cameraFrustum.IntersectsSweptSphere(object.boundsCenter,
+          lightPos + toObject * (range / distance),
+          glm::max(shadowRadius, object.boundsRadius)))
+    {
+      RecordObject(list, object, false);
+    }
+  }
+}
+
+// point light i's faces start at i * 6, the spot lights come after them
+CommandList* AtlasCommands(PointLight* pointLight)
+{
+  return &atlasCommands[(pointLight - pointLights) * 6];
 }
 
-void DirectionalShadowMapPass(DirectionalLight* light)
+CommandList* AtlasCommands(SpotLight* spotLight)
+{
+  return &atlasCommands[MAX_POINT_LIGHTS * 6 + (spotLight - spotLights)];
+}
+
+std::vector<glm::mat4>& ShadowMatrices(PointLight* pointLight)
+{
+  return shadowMatrices[pointLight - pointLights];
+}
+
+std::vector<glm::mat4>& ShadowMatrices(SpotLight* spotLight)
+{
+  return shadowMatrices[MAX_POINT_LIGHTS + (spotLight - spotLights)];
+}
+
+// The simulation thread's share of recording, the passes that only need
+// the camera. The directional light never moves, so reading it from here
+// is safe.
+//
+//   camera frustum -> directional casters, main and pre-pass lists
+void RecordCameraPasses(FrameState& frame, const glm::mat4& projection)
+{
+  frame.cameraFrustum = Frustum(projection * frame.viewMatrix);
+
+  Job* directional = JobSystem::Create([&frame]()
+  {
+    RecordDirectionalCasters(frame.directionalCommands, frame,
+        Frustum(mainLight.CalculateLightTransform()), &mainLight);
+  });
+
+  Job* scene = JobSystem::Create([&frame]()
+  {
+    RecordScene(frame.mainCommands, frame, true);
+  });
+
+  // always recorded, whether it's used is up to the GL thread
+  Job* depth = JobSystem::Create([&frame]()
+  {
+    RecordScene(frame.depthCommands, frame, false);
+  });
+
+  // does nothing, done once everything else is
+  Job* all = JobSystem::Create([]() {});
+  JobSystem::AddDependency(all, directional);
+  JobSystem::AddDependency(all, scene);
+  JobSystem::AddDependency(all, depth);
+
+  JobSystem::Run(all);
+  JobSystem::Run(directional);
+  JobSystem::Run(scene);
+  JobSystem::Run(depth);
+
+  // this thread works through the graph as well
+  JobSystem::Wait(all);
+  JobSystem::EndFrame();
+}
+
+// The GL thread's share, everything that touches the lights or the atlas.
+// Only the GL work is left when it returns.
+//
+//   scheduler -> each light's casters
+//   each light's matrices ---^
+void RecordShadowPasses(FrameState& frame)
+{
+  std::vector<Job*> jobs;
+
+  // only some of the lights get their shadows redrawn each frame, the
+  // rest keep what's already in the atlas
+  Job* schedule = JobSystem::Create([&frame]()
+  {
+    shadowScheduler.Schedule(shadowAtlas,
+        pointLights, pointLightCount,
+        spotLights, spotLightCount,
+        frame.cameraFrustum,
+        frame.eyePosition, fieldOfView);
+  });
+  jobs.push_back(schedule);
+
+  for (size_t i = 0; i < pointLightCount; i++)
+  {
+    PointLight* light = &pointLights[i];
+
+    Job* matrices = JobSystem::Create([light]()
+    {
+      ShadowMatrices(light) = light->CalculateLightTransform();
+    });
+
+    // a face to a job, they're each about as much work as a spot light
+    Job* casters = JobSystem::Create([light, &frame]()
+    {
+      if (!shadowScheduler.ShouldUpdate(light) || !light->HasShadowTiles())
+      {
+        return;
+      }
+
+      JobSystem::ParallelFor(6, 1, [light, &frame](size_t begin, size_t end)
+      {
+        for (size_t face = begin; face < end; face++)
+        {
+          RecordPointCasters(AtlasCommands(light)[face], frame,
+              Frustum(ShadowMatrices(light)[face]), light);
+        }
+      });
+    });
+    JobSystem::AddDependency(casters, schedule);
+    JobSystem::AddDependency(casters, matrices);
+
+    jobs.push_back(matrices);
+    jobs.push_back(casters);
+  }
+
+  for (size_t i = 0; i < spotLightCount; i++)
+  {
+    SpotLight* light = &spotLights[i];
+
+    Job* matrices = JobSystem::Create([light]()
+    {
+      ShadowMatrices(light) = light->CalculateLightTransform();
+    });
+
+    Job* casters = JobSystem::Create([light, &frame]()
+    {
+      if (!shadowScheduler.ShouldUpdate(light) || !light->HasShadowTiles())
+      {
+        return;
+      }
+
+      RecordPointCasters(*AtlasCommands(light), frame,
+          Frustum(ShadowMatrices(light)[0]), light);
+    });
+    JobSystem::AddDependency(casters, schedule);
+    JobSystem::AddDependency(casters, matrices);
+
+    jobs.push_back(matrices);
+    jobs.push_back(casters);
+  }
+
+  // does nothing, done once everything else is
+  Job* all = JobSystem::Create([]() {});
+  for (size_t i = 0; i < jobs.size(); i++)
+  {
+    JobSystem::AddDependency(all, jobs[i]);
+  }
+
+  JobSystem::Run(all);
+  for (size_t i = 0; i < jobs.size(); i++)
+  {
+    JobSystem::Run(jobs[i]);
+  }
+
+  JobSystem::Wait(all);
+  JobSystem::EndFrame();
+}
+
+void DirectionalShadowMapPass(DirectionalLight* light, FrameState& frame)
 {
   directionalShadowShader.UseShader();
   glViewport(0, 0,
@@ -269,101 +732,313 @@ void DirectionalShadowMapPass(DirectionalLight* light)
   light->GetShadowMap()->Write();
   glClear(GL_DEPTH_BUFFER_BIT);
 
-  uniformModel = directionalShadowShader.GetModelLocation();
   //directionalShadowShader.SetDirectionalLightTransform(&light->CalculateLightTransform());
   glm::mat4 foo = light->CalculateLightTransform();
   directionalShadowShader.SetDirectionalLightTransform(&foo);
 
   directionalShadowShader.Validate();
 
-  RenderScene();
+  RenderCasters(frame.directionalCommands);
+
+  // blurs it, for variance shadows
+  light->GetShadowMap()->Filter();
 
   // unbind
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+// Each face is drawn into its own tile of the atlas. Has to be between
+// shadowAtlas.Write() and EndWrite().
 void OmniShadowMapPass(PointLight* light)
 {
-  omniShadowShader.UseShader();
-  glViewport(0, 0,
-      light->GetShadowMap()->GetShadowWidth(),
-      light->GetShadowMap()->GetShadowHeight());
+  if (!light->HasShadowTiles())
+  {
+    return;
+  }
 
-  light->GetShadowMap()->Write();
-  glClear(GL_DEPTH_BUFFER_BIT);
+  atlasShadowShader.UseShader();
 
-  uniformModel = omniShadowShader.GetModelLocation();
-  uniformOmniLightPos = omniShadowShader.GetOmniLightPosLocation();
-  uniformFarPlane = omniShadowShader.GetFarPlaneLocation();
+  std::vector<glm::mat4>& lightMatrices = ShadowMatrices(light);
+  ShadowTile* tiles = light->GetShadowTiles();
+  CommandList* faceCommands = AtlasCommands(light);
 
-  glUniform3f(uniformOmniLightPos,
-      light->GetPosition().x,
-      light->GetPosition().y,
-      light->GetPosition().z);
-  glUniform1f(uniformFarPlane, light->GetFarPlane());
-  omniShadowShader.SetLightMatrices(light->CalculateLightTransform());
+  for (size_t i = 0; i < lightMatrices.size(); i++)
+  {
+    shadowAtlas.WriteTile(tiles[i]);
+    atlasShadowShader.SetLightMatrix(&lightMatrices[i]);
 
-  omniShadowShader.Validate();
+    atlasShadowShader.Validate();
 
-  RenderScene();
+    // each face only has what's in front of it
+    RenderCasters(faceCommands[i]);
+  }
+}
 
-  // unbind
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+// A spot light only needs the one view down its cone, so it's one draw of
+// the scene instead of six. Same as OmniShadowMapPass, between
+// shadowAtlas.Write() and EndWrite().
+void SpotShadowMapPass(SpotLight* light)
+{
+  if (!light->HasShadowTiles())
+  {
+    return;
+  }
+
+  atlasShadowShader.UseShader();
+  shadowAtlas.WriteTile(light->GetShadowTiles()[0]);
+
+  glm::mat4 lightMatrix = ShadowMatrices(light)[0];
+  atlasShadowShader.SetLightMatrix(&lightMatrix);
+
+  atlasShadowShader.Validate();
+
+  RenderCasters(*AtlasCommands(light));
+}
+
+// Rebuilds every shadow map for the current tier. The atlas only ever
+// shrinks, on higher tiers the lights ask for bigger tiles out of the same
+// atlas instead.
+void ApplyShadowQuality()
+{
+  const ShadowQuality& quality = ShadowQuality::Get(shadowQualityTier);
+
+  mainLight.SetShadowQuality(quality);
+
+  for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+  {
+    pointLights[i].SetShadowQuality(quality);
+  }
+
+  for (int i = 0; i < MAX_SPOT_LIGHTS; i++)
+  {
+    spotLights[i].SetShadowQuality(quality);
+  }
+
+  shadowAtlas.Init((GLuint)(SHADOW_ATLAS_SIZE * glm::min(quality.scale, 1.0f)), quality.atlasFormat);
+  shadowScheduler.Invalidate();
 }
 
-void RenderPass(glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+// whether anything has a shadow to look up this frame
+bool AnyShadows()
 {
-  shaderList[0].UseShader();
+  if (mainLight.GetShadowMap())
+  {
+    return true;
+  }
 
-  uniformModel = shaderList[0].GetModelLocation();
-  uniformProjection = shaderList[0].GetProjectionLocation();
-  uniformView = shaderList[0].GetViewLocation();
-  uniformEyePosition = shaderList[0].GetEyePositionLocation();
-  uniformSpecularIntensity = shaderList[0].GetSpecularIntensityLocation();
-  uniformShininess = shaderList[0].GetShininessLocation();
+  for (size_t i = 0; i < pointLightCount; i++)
+  {
+    if (pointLights[i].HasShadowTiles())
+    {
+      return true;
+    }
+  }
 
+  for (size_t i = 0; i < spotLightCount; i++)
+  {
+    if (spotLights[i].HasShadowTiles())
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// the cheapest variant that matches what's in the scene right now
+ShaderKey CurrentShaderKey()
+{
+  return ShaderKey(pointLightCount, spotLightCount, AnyShadows(),
+      ShadowQuality::Get(shadowQualityTier).pcfRadius);
+}
+
+void DepthPrepass(FrameState& frame, glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+  depthPrepassShader.UseShader();
+
+  UniformState::SetMatrix4fv(depthPrepassShader.GetProjectionLocation(), glm::value_ptr(projectionMatrix));
+  UniformState::SetMatrix4fv(depthPrepassShader.GetViewLocation(), glm::value_ptr(viewMatrix));
+
+  // depth only, nothing gets written to the color buffer
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  frame.depthCommands.Execute(-1, -1);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void RenderPass(FrameState& frame, glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
   glViewport(0, 0, 1024, 768);
 
   // Clear window
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+  if (depthPrepassEnabled)
+  {
+    DepthPrepass(frame, viewMatrix, projectionMatrix);
+  }
+
+  // the generic shader handles any scene, so it fills in while the
+  // specialised one is still being built
+  Shader* shader = lightingShaders.Get(CurrentShaderKey());
+  if (!shader->IsReady())
+  {
+    shader = shaderList[0];
+  }
+
+  shader->UseShader();
+
+  uniformProjection = shader->GetProjectionLocation();
+  uniformView = shader->GetViewLocation();
+  uniformEyePosition = shader->GetEyePositionLocation();
+  uniformSpecularIntensity = shader->GetSpecularIntensityLocation();
+  uniformShininess = shader->GetShininessLocation();
+
   // the Position of these two lines doesn't matter so long as they are done
   // before the very first draw
-  glUniformMatrix4fv(uniformProjection, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-  glUniformMatrix4fv(uniformView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-  glUniform3f(uniformEyePosition,
-      camera.getCameraPosition().x,
-      camera.getCameraPosition().y,
-      camera.getCameraPosition().z);
+  // these only reach the driver when they've changed since last frame
+  UniformState::SetMatrix4fv(uniformProjection, glm::value_ptr(projectionMatrix));
+  UniformState::SetMatrix4fv(uniformView, glm::value_ptr(viewMatrix));
+  UniformState::Set3f(uniformEyePosition,
+      frame.eyePosition.x,
+      frame.eyePosition.y,
+      frame.eyePosition.z);
 
   // Use our light source
-  shaderList[0].SetDirectionalLight(&mainLight);
-  shaderList[0].SetPointLights(pointLights, pointLightCount, 3, 0);
-  shaderList[0].SetSpotLights(spotLights, spotLightCount, 3 + pointLightCount, pointLightCount);
+  shader->SetDirectionalLight(&mainLight);
+  shader->SetPointLights(pointLights, pointLightCount, 0);
+  shader->SetSpotLights(spotLights, spotLightCount, pointLightCount);
 
-  //shaderList[0].SetDirectionalLightTransform(&mainLight.CalculateLightTransform());
+  //shader->SetDirectionalLightTransform(&mainLight.CalculateLightTransform());
   glm::mat4 foo = mainLight.CalculateLightTransform();
-  shaderList[0].SetDirectionalLightTransform(&foo);
+  shader->SetDirectionalLightTransform(&foo);
 
   mainLight.GetShadowMap()->Read(GL_TEXTURE2);
-  shaderList[0].SetTexture(1);
-  shaderList[0].SetDirectionalShadowMap(2);
+  shader->SetTexture(DIFFUSE_TEXTURE_UNIT);
+  TextureTable::Bind();
+  shader->SetDirectionalShadowMap(2);
+  shader->SetShadowAtlas(SHADOW_ATLAS_UNIT);
 
-  glm::vec3 lowerLight = camera.getCameraPosition();
+  glm::vec3 lowerLight = frame.eyePosition;
   lowerLight.y -= 0.3f;
-  spotLights[0].SetFlash(lowerLight, camera.getCameraDirection());
+  spotLights[0].SetFlash(lowerLight, frame.eyeDirection);
   
-  shaderList[0].Validate();
+  shader->Validate();
+
+  // with the depth already there, only the nearest fragment of each pixel
+  // passes and the depth buffer doesn't need writing again
+  if (depthPrepassEnabled)
+  {
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+  }
+
+  shadedFragments.Begin();
+  frame.mainCommands.Execute(uniformSpecularIntensity, uniformShininess);
+  shadedFragments.End();
 
-  RenderScene();
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+}
+
+// Same scene and lights as RenderPass, but each light only shades the
+// pixels inside its volume. The depth pre-pass doesn't apply here, the
+// G-buffer already means every pixel is lit once per light.
+void DeferredRenderPass(FrameState& frame, glm::mat4 viewMatrix, glm::mat4 projectionMatrix)
+{
+  deferredRenderer.BeginGeometryPass(viewMatrix, projectionMatrix);
+
+  // the materials come from the draw data, these are just -1
+  uniformSpecularIntensity = deferredRenderer.GetGeometryShader()->GetSpecularIntensityLocation();
+  uniformShininess = deferredRenderer.GetGeometryShader()->GetShininessLocation();
+
+  frame.mainCommands.Execute(uniformSpecularIntensity, uniformShininess);
+  deferredRenderer.EndGeometryPass();
+
+  glm::vec3 lowerLight = frame.eyePosition;
+  lowerLight.y -= 0.3f;
+  spotLights[0].SetFlash(lowerLight, frame.eyeDirection);
+
+  // here the count is pixels lit, added up over every light
+  shadedFragments.Begin();
+  deferredRenderer.LightingPass(viewMatrix, projectionMatrix,
+      frame.eyePosition,
+      &mainLight,
+      pointLights, pointLightCount,
+      spotLights, spotLightCount);
+  shadedFragments.End();
+}
+
+// Frame N+1 gets simulated here while the GL thread draws frame N, so a
+// frame takes as long as the slower of the two instead of both added up.
+// Input, the camera, animation and culling all happen here, nothing that
+// needs the GL context.
+void SimulationLoop(glm::mat4 projection)
+{
+  // its graphs go on a queue of their own, not the GL thread's
+  JobSystem::RegisterThread();
+
+  GLfloat lastSimulationTime = glfwGetTime();
+
+  while (simulationRunning)
+  {
+    // both frames are still waiting to be drawn
+    {
+      std::unique_lock<std::mutex> lock(frameMutex);
+      emptyFrameReady.wait(lock, []() { return !emptyFrames.Empty() || !simulationRunning; });
+    }
+
+    FrameState* frame;
+    if (!emptyFrames.Pop(frame))
+    {
+      // woken to stop
+      break;
+    }
+
+    GLfloat now = glfwGetTime();
+    GLfloat simulationDelta = now - lastSimulationTime;
+    lastSimulationTime = now;
+
+    // User input for the camera
+    camera.keyControl(frame->keys, simulationDelta);
+    camera.mouseControl(frame->xChange, frame->yChange);
+
+    frame->viewMatrix = camera.calculateViewMatrix();
+    frame->eyePosition = camera.getCameraPosition();
+    frame->eyeDirection = camera.getCameraDirection();
+
+    UpdateScene(*frame);
+    RecordCameraPasses(*frame, projection);
+
+    HandOver(readyFrames, readyFrameReady, frame);
+  }
 }
 
 int main()
 {
+  // everything below loads through the pack if it's there, loose files if not
+  FileSystem::Mount("assets.pak");
+
   mainWindow = Window(1024, 768);
   mainWindow.initialize();
 
+  // The GL and simulation threads each keep a core busy, the workers get
+  // whatever's left. Init counts this thread, and keeps a queue for the
+  // simulation thread to register.
+  size_t cores = std::thread::hardware_concurrency();
+  size_t workerCount = cores > 2 ? cores - 2 : 0;
+  JobSystem::Init(workerCount + 1, 1);
+
+  // has to know the mode before the shaders get built
+  TextureTable::Init();
+
+  // rebuild shaders when their files are saved
+  ShaderWatcher::Init();
+
+  DrawData::Init();
+  shadedFragments.Init();
+  shadowAtlas.Init(SHADOW_ATLAS_SIZE, ShadowQuality::Get(shadowQualityTier).atlasFormat);
+
   CreateObjects();
   CreateShaders();
 
@@ -375,14 +1050,20 @@ int main()
       0.5f);
 
   brickTexture = Texture("Textures/brick.png");
-  brickTexture.LoadTextureA();
-
   dirtTexture = Texture("Textures/dirt.png");
-  dirtTexture.LoadTextureA();
-
   plainTexture = Texture("Textures/plain.png");
+
+  std::vector<Texture*> sceneTextures = { &brickTexture, &dirtTexture, &plainTexture };
+  Texture::DecodeAll(sceneTextures);
+
+  brickTexture.LoadTextureA();
+  dirtTexture.LoadTextureA();
   plainTexture.LoadTextureA();
 
+  TextureTable::Add(&brickTexture);
+  TextureTable::Add(&dirtTexture);
+  TextureTable::Add(&plainTexture);
+
   shinyMaterial = Material(4.0f, 256);
   dullMaterial = Material(0.3f, 4);
 
@@ -392,6 +1073,9 @@ int main()
   blackhawk = Model();
   blackhawk.LoadModel("Models/uh60.obj");
 
+  // every texture is loaded now, including the models' own
+  TextureTable::Build();
+
   mainLight = DirectionalLight(
       2048, 2048,
       1.0f, 1.0f, 1.0f,
@@ -440,13 +1124,29 @@ int main()
       20.0f);
   //spotLightCount++;
 
+  // start building the variant for this scene now, so it's usually done
+  // before the first frame asks for it
+  lightingShaders.Get(CurrentShaderKey());
+
   // Prepare the projection matrix
   glm::mat4 projection = glm::perspective(
-      glm::radians(60.0f),
+      fieldOfView,
       (GLfloat)mainWindow.getBufferWidth() / mainWindow.getBufferHeight(), 
       0.1f,
       100.0f);
 
+  // both frames start out empty, with no input yet
+  for (size_t i = 0; i < 2; i++)
+  {
+    memset(frameStates[i].keys, 0, sizeof(frameStates[i].keys));
+    frameStates[i].xChange = 0.0f;
+    frameStates[i].yChange = 0.0f;
+    emptyFrames.Push(&frameStates[i]);
+  }
+
+  simulationRunning = true;
+  std::thread simulation(SimulationLoop, projection);
+
   // loop until window closed
   while (!mainWindow.getShouldClose())
   {
@@ -457,28 +1157,109 @@ int main()
     // Get and handle user input events
     glfwPollEvents();
 
-    // User input for the camera
-    camera.keyControl(mainWindow.getKeys(), deltaTime);
-    camera.mouseControl(mainWindow.getXChange(), mainWindow.getYChange());
+    // pick up any shader edits before drawing anything with them
+    ShaderWatcher::Poll();
+
+    // P toggles the depth pre-pass, once per press
+    bool* keys = mainWindow.getKeys();
+    if (keys[GLFW_KEY_P] && !prepassKeyHeld)
+    {
+      printf("Fragments shaded: %u (depth pre-pass %s)\n",
+          shadedFragments.GetLastResult(),
+          depthPrepassEnabled ? "on" : "off");
 
-    DirectionalShadowMapPass(&mainLight);
+      depthPrepassEnabled = !depthPrepassEnabled;
+      printf("Depth pre-pass %s\n", depthPrepassEnabled ? "on" : "off");
+    }
+    prepassKeyHeld = keys[GLFW_KEY_P];
+
+    if (keys[GLFW_KEY_G] && !deferredKeyHeld)
+    {
+      printf("Fragments shaded: %u (%s)\n",
+          shadedFragments.GetLastResult(),
+          deferredEnabled ? "deferred" : "forward");
+
+      deferredEnabled = !deferredEnabled;
+      printf("Deferred shading %s\n", deferredEnabled ? "on" : "off");
+    }
+    deferredKeyHeld = keys[GLFW_KEY_G];
+
+    if (keys[GLFW_KEY_Q] && !qualityKeyHeld)
+    {
+      shadowQualityTier = (shadowQualityTier + 1) % ShadowQuality::tierCount;
+      ApplyShadowQuality();
+      printf("Shadow quality %s\n", ShadowQuality::Get(shadowQualityTier).name);
+    }
+    qualityKeyHeld = keys[GLFW_KEY_Q];
+
+    // the next frame the simulation thread has finished
+    {
+      std::unique_lock<std::mutex> lock(frameMutex);
+      readyFrameReady.wait(lock, []() { return !readyFrames.Empty(); });
+    }
+
+    FrameState* frame;
+    readyFrames.Pop(frame);
+
+    UploadScene(*frame);
+
+    // everything below only replays what's recorded by now
+    RecordShadowPasses(*frame);
+
+    DirectionalShadowMapPass(&mainLight, *frame);
+
+    shadowAtlas.Write();
 
     // Point light shadows
     for (size_t i = 0; i < pointLightCount; i++)
     {
-      OmniShadowMapPass(&pointLights[i]);
+      if (shadowScheduler.ShouldUpdate(&pointLights[i]))
+      {
+        OmniShadowMapPass(&pointLights[i]);
+      }
     }
 
     // Spot light shadows
     for (size_t i = 0; i < spotLightCount; i++)
     {
-      OmniShadowMapPass(&spotLights[i]);
+      if (shadowScheduler.ShouldUpdate(&spotLights[i]))
+      {
+        SpotShadowMapPass(&spotLights[i]);
+      }
+    }
+
+    shadowAtlas.EndWrite();
+    shadowAtlas.Read(GL_TEXTURE0 + SHADOW_ATLAS_UNIT);
+
+    if (deferredEnabled)
+    {
+      DeferredRenderPass(*frame, frame->viewMatrix, projection);
+    }
+    else
+    {
+      RenderPass(*frame, frame->viewMatrix, projection);
     }
+    DrawData::EndFrame();
 
-    RenderPass(camera.calculateViewMatrix(), projection);
+    // back to the simulation thread, with the input it needs for the next
+    // one. The GL work is only queued up by now, the driver and GPU catch
+    // up while the simulation runs.
+    memcpy(frame->keys, mainWindow.getKeys(), sizeof(frame->keys));
+    frame->xChange = mainWindow.getXChange();
+    frame->yChange = mainWindow.getYChange();
+    HandOver(emptyFrames, emptyFrameReady, frame);
 
     mainWindow.swapBuffers();
   }
 
+  // under the lock, so it can't miss the wake up either
+  {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    simulationRunning = false;
+  }
+  emptyFrameReady.notify_one();
+  simulation.join();
+
+  JobSystem::Shutdown();
   return 0;
 }